@@ -0,0 +1,111 @@
+#include "mymuduo/net/Buffer.h"
+
+#include <cstddef>
+#include <string>
+#include <benchmark/benchmark.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+namespace bm = benchmark;
+
+namespace {
+
+// 改造前 pick_datagram 的逐字节查找, 作为对照
+bool naive_pick_datagram(Buffer& buf, std::string& msg) {
+    const char* start = buf.cbegin() + buf.prependable();
+    const std::size_t n = buf.readable();
+
+    for(std::size_t i = 0; i + 3 < n; i++) {
+        if(std::string{start + i, start + i + 4} == "\r\n\r\n") {
+            msg.assign(start, i);
+            buf.retrieve(i + 4);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string make_frame(std::size_t size) {
+    std::string frame(size, '\0');
+    for(std::size_t i = 0; i < size; ++i) {
+        // 夹杂'\r'和'\n', 让标量的memchr也频繁命中候选位置
+        frame[i] = (i % 61 == 0) ? '\r' : (i % 67 == 0) ? '\n' : static_cast<char>('a' + i % 26);
+    }
+    frame.append("\r\n\r\n");
+    return frame;
+}
+
+} // namespace
+
+
+// TAG: 报文以 ChunkSize 为单位陆续到达, 每到达一次就尝试取一次报文
+template <bool Naive>
+void BM_PickDatagram(bm::State& state) {
+    const std::size_t FrameSize = state.range(0);   // 报文大小
+    const std::size_t ChunkSize = state.range(1);   // 每次到达的字节数
+
+    const std::string frame = make_frame(FrameSize);
+    std::string msg;
+
+    for (auto _ : state) {
+        Buffer buf;
+        buf.set_sep(Buffer::DelimiterSuffix);
+
+        bool picked = false;
+        for(std::size_t off = 0; off < frame.size(); off += ChunkSize) {
+            buf.append(frame.data() + off, std::min(ChunkSize, frame.size() - off));
+            picked = Naive ? naive_pick_datagram(buf, msg) : buf.pick_datagram(msg);
+        }
+
+        if(!picked) {
+            state.SkipWithError("frame not picked");
+            break;
+        }
+        bm::DoNotOptimize(msg.data());
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * frame.size());
+}
+
+
+// TAG: 一次性到达的完整报文, 只衡量查找本身
+template <bool Naive>
+void BM_PickDatagramWhole(bm::State& state) {
+    const std::size_t FrameSize = state.range(0);
+    const std::string frame = make_frame(FrameSize);
+    std::string msg;
+
+    Buffer buf;
+    buf.set_sep(Buffer::DelimiterSuffix);
+
+    for (auto _ : state) {
+        buf.append(frame.data(), frame.size());
+        bool picked = Naive ? naive_pick_datagram(buf, msg) : buf.pick_datagram(msg);
+        bm::DoNotOptimize(picked);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * frame.size());
+}
+
+
+// MARK: 两组使用相同的范围才能对比; 重复扫描的代价在大报文时才明显, 1MB时朴素实现每次迭代约扫描128MB, 仍可接受
+BENCHMARK(BM_PickDatagram<true>)
+    ->Name("BM_PickDatagram/Naive")
+    ->ArgsProduct({ bm::CreateRange(1 << 10, 1 << 20, 8), { 4096 } })
+    ->Unit(bm::kMicrosecond);
+
+BENCHMARK(BM_PickDatagram<false>)
+    ->Name("BM_PickDatagram/Resumable")
+    ->ArgsProduct({ bm::CreateRange(1 << 10, 1 << 20, 8), { 4096 } })
+    ->Unit(bm::kMicrosecond);
+
+BENCHMARK(BM_PickDatagramWhole<true>)
+    ->Name("BM_PickDatagramWhole/Naive")
+    ->RangeMultiplier(8)->Range(1 << 10, 1 << 20)
+    ->Unit(bm::kMicrosecond);
+
+BENCHMARK(BM_PickDatagramWhole<false>)
+    ->Name("BM_PickDatagramWhole/SIMD")
+    ->RangeMultiplier(8)->Range(1 << 10, 1 << 20)
+    ->Unit(bm::kMicrosecond);
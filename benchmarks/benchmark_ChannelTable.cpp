@@ -0,0 +1,142 @@
+#include "mymuduo/net/Channel.h"
+#include "mymuduo/net/ChannelTable.h"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+namespace bm = benchmark;
+
+namespace {
+
+// 原先Poller使用的 unordered_map<int, Channel*>
+struct MapTable {
+    void insert(Channel* ch) { _map[ch->fd()] = ch; }
+    void erase(int fd) { _map.erase(fd); }
+    Channel* find(int fd) const {
+        auto it = _map.find(fd);
+        return it != _map.end() ? it->second : nullptr;
+    }
+
+    std::unordered_map<int, Channel*> _map;
+};
+
+struct VectorTable {
+    void insert(Channel* ch) { _table.insert(ch); }
+    void erase(int fd) { _table.erase(fd); }
+    Channel* find(int fd) const { return _table.find(fd); }
+
+    ChannelTable _table;
+};
+
+// N个fd从0开始连续分配的Channel(与内核分配fd的方式相同)
+std::vector<std::unique_ptr<Channel>> make_channels(int num_fds) {
+    std::vector<std::unique_ptr<Channel>> channels;
+    channels.reserve(num_fds);
+    for(int fd = 0; fd < num_fds; ++fd) {
+        channels.emplace_back(std::make_unique<Channel>(nullptr, fd));
+    }
+    return channels;
+}
+
+
+// TAG: 保持N个连接, 每次迭代随机关闭一个再在同一个fd上建立新连接(删除, 注册, 查找)
+template <typename Table>
+void BM_RegisterChurn(bm::State& state) {
+    const int num_fds = state.range(0);
+    auto channels = make_channels(num_fds);
+    auto fresh = make_channels(num_fds);
+
+    Table table;
+    for(auto& ch : channels) {
+        table.insert(ch.get());
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(0, num_fds - 1);
+    for(auto _ : state) {
+        const int fd = dist(rng);
+        table.erase(fd);
+        table.insert(fresh[fd].get());
+        bm::DoNotOptimize(table.find(fd));
+        std::swap(channels[fd], fresh[fd]);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+// TAG: 保持N个连接, 每次迭代随机查找一个fd(对应poll返回后按fd查找Channel)
+template <typename Table>
+void BM_Lookup(bm::State& state) {
+    const int num_fds = state.range(0);
+    auto channels = make_channels(num_fds);
+
+    Table table;
+    for(auto& ch : channels) {
+        table.insert(ch.get());
+    }
+
+    std::mt19937 rng(42);
+    std::vector<int> fds(4096);
+    for(int& fd : fds) {
+        fd = std::uniform_int_distribution<int>(0, num_fds - 1)(rng);
+    }
+
+    std::size_t i = 0;
+    for(auto _ : state) {
+        bm::DoNotOptimize(table.find(fds[i++ & (fds.size() - 1)]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+// TAG: 从空表开始注册N个连接再全部删除
+template <typename Table>
+void BM_FillDrain(bm::State& state) {
+    const int num_fds = state.range(0);
+    auto channels = make_channels(num_fds);
+
+    for(auto _ : state) {
+        Table table;
+        for(auto& ch : channels) {
+            table.insert(ch.get());
+        }
+        for(auto& ch : channels) {
+            table.erase(ch->fd());
+        }
+        bm::DoNotOptimize(table);
+    }
+    state.SetItemsProcessed(state.iterations() * num_fds);
+}
+
+} // namespace
+
+BENCHMARK(BM_RegisterChurn<MapTable>)
+    ->Name("BM_RegisterChurn/UnorderedMap")
+    ->RangeMultiplier(8)->Range(64, 128 << 10);
+
+BENCHMARK(BM_RegisterChurn<VectorTable>)
+    ->Name("BM_RegisterChurn/ChannelTable")
+    ->RangeMultiplier(8)->Range(64, 128 << 10);
+
+BENCHMARK(BM_Lookup<MapTable>)
+    ->Name("BM_Lookup/UnorderedMap")
+    ->RangeMultiplier(8)->Range(64, 128 << 10);
+
+BENCHMARK(BM_Lookup<VectorTable>)
+    ->Name("BM_Lookup/ChannelTable")
+    ->RangeMultiplier(8)->Range(64, 128 << 10);
+
+BENCHMARK(BM_FillDrain<MapTable>)
+    ->Name("BM_FillDrain/UnorderedMap")
+    ->RangeMultiplier(8)->Range(64, 128 << 10);
+
+BENCHMARK(BM_FillDrain<VectorTable>)
+    ->Name("BM_FillDrain/ChannelTable")
+    ->RangeMultiplier(8)->Range(64, 128 << 10);
@@ -0,0 +1,178 @@
+#include "mymuduo/base/MpscQueue.h"
+#include "mymuduo/base/Task.h"
+#include "mymuduo/net/EventLoop.h"
+#include "mymuduo/net/EventLoopThread.h"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+namespace bm = benchmark;
+
+namespace {
+
+using Functor = std::function<void()>;
+
+// 每次迭代投递的任务总数, 平均分给各个生产者
+constexpr int kTasks = 1 << 16;
+
+// 改造前 EventLoop 的任务队列: 互斥锁 + vector, 入队时拷贝任务, 取出时整体交换
+class MutexQueue {
+public:
+    void push(Functor task) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.emplace_back(task);
+    }
+
+    std::size_t drain() {
+        std::vector<Functor> tasks;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            tasks.swap(_tasks);
+        }
+        for(const Functor& task : tasks) {
+            task();
+        }
+        return tasks.size();
+    }
+
+private:
+    std::mutex _mutex;
+    std::vector<Functor> _tasks;
+};
+
+class LockFreeQueue {
+public:
+    void push(Functor task) {
+        _tasks.push(std::move(task));
+    }
+
+    std::size_t drain() {
+        std::size_t count = 0;
+        Functor task;
+        while(_tasks.pop(task)) {
+            task();
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    MpscQueue<Functor> _tasks;
+};
+
+
+// TAG: N个生产者投递任务, 当前线程作为唯一的消费者不断取出执行
+template <typename Queue>
+void BM_TaskQueue(bm::State& state) {
+    const int producers = state.range(0);
+    Queue queue;
+    std::atomic<int> counter { 0 };
+
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        for(int p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                for(int i = 0; i < kTasks / producers; ++i) {
+                    queue.push([&counter] { counter.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+
+        std::size_t done = 0;
+        while(done < static_cast<std::size_t>(kTasks / producers * producers)) {
+            done += queue.drain();
+        }
+
+        for(auto& t : threads) {
+            t.join();
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * (kTasks / producers * producers));
+}
+
+
+// TAG: N个生产者通过 queue_in_loop 向同一个sub loop投递任务, 直到loop执行完全部任务
+void BM_QueueInLoop(bm::State& state) {
+    const int producers = state.range(0);
+    const int total = kTasks / producers * producers;
+
+    EventLoopThread thread;
+    EventLoop* loop = thread.start_loop();
+    std::atomic<int> counter { 0 };
+
+    for (auto _ : state) {
+        counter = 0;
+
+        std::vector<std::thread> threads;
+        for(int p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                for(int i = 0; i < kTasks / producers; ++i) {
+                    loop->queue_in_loop([&counter] { counter.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+
+        for(auto& t : threads) {
+            t.join();
+        }
+        while(counter.load(std::memory_order_relaxed) < total) {
+            std::this_thread::yield();
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * total);
+}
+
+
+// TAG: 构造并执行一个捕获了 shared_ptr 和 std::string 的任务(与跨线程 send 的捕获相同)
+//      std::function 的内联存储放不下, 每个任务都要申请一次堆内存
+template <typename Wrapper>
+void BM_WrapTask(bm::State& state) {
+    auto owner = std::make_shared<int>(0);
+    std::string message(state.range(0), 'x');
+    std::size_t bytes = 0;
+
+    for (auto _ : state) {
+        Wrapper task([owner, message, &bytes] { bytes += message.size(); });
+        task();
+    }
+
+    bm::DoNotOptimize(bytes);
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+
+BENCHMARK(BM_WrapTask<std::function<void()>>)
+    ->Name("BM_WrapTask/StdFunction")
+    ->Arg(8);
+
+BENCHMARK(BM_WrapTask<Task>)
+    ->Name("BM_WrapTask/Task")
+    ->Arg(8);
+
+BENCHMARK(BM_TaskQueue<MutexQueue>)
+    ->Name("BM_TaskQueue/Mutex")
+    ->RangeMultiplier(2)->Range(1, 8)
+    ->UseRealTime()->Unit(bm::kMillisecond);
+
+BENCHMARK(BM_TaskQueue<LockFreeQueue>)
+    ->Name("BM_TaskQueue/Mpsc")
+    ->RangeMultiplier(2)->Range(1, 8)
+    ->UseRealTime()->Unit(bm::kMillisecond);
+
+BENCHMARK(BM_QueueInLoop)
+    ->RangeMultiplier(2)->Range(1, 8)
+    ->UseRealTime()->Unit(bm::kMillisecond);
@@ -0,0 +1,147 @@
+#include "mymuduo/net/Channel.h"
+#include "mymuduo/net/EventLoop.h"
+#include "mymuduo/net/SocketOps.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <benchmark/benchmark.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+namespace bm = benchmark;
+
+namespace {
+
+struct EPollBackend {
+    static constexpr const char* kEnv = nullptr;
+};
+
+struct PollBackend {
+    static constexpr const char* kEnv = "MUDUO_USE_POLL";
+};
+
+// 按Backend选择Poller创建一个EventLoop, 再注册N个监听读事件的eventfd
+template <typename Backend>
+class PollerFixture {
+public:
+    explicit PollerFixture(int num_fds) {
+        // 环境中已有的选择变量会让epoll的对照组换成其它的Poller, 先全部清除
+        ::unsetenv("MUDUO_USE_POLL");
+        ::unsetenv("MUDUO_USE_URING");
+        if constexpr (Backend::kEnv != nullptr) {
+            ::setenv(Backend::kEnv, "1", 1);
+        }
+        _loop = std::make_unique<EventLoop>();
+        if constexpr (Backend::kEnv != nullptr) {
+            ::unsetenv(Backend::kEnv);
+        }
+
+        for(int i = 0; i < num_fds; ++i) {
+            int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            auto ch = std::make_unique<Channel>(_loop.get(), fd);
+            ch->set_read_callback([](Timestamp) {});
+            ch->set_read_events();
+            _channels.emplace_back(std::move(ch));
+        }
+    }
+
+    ~PollerFixture() {
+        for(auto& ch : _channels) {
+            ch->unset_all_events();
+            ch->remove();
+            sockets::close(ch->fd());
+        }
+    }
+
+    EventLoop* loop() { return _loop.get(); }
+    Channel* channel(int i) { return _channels[i].get(); }
+
+    // 让第i个fd一直可读(LT下每一轮都会触发)
+    void make_readable(int i) {
+        uint64_t one = 1;
+        ::write(_channels[i]->fd(), &one, sizeof(one));
+    }
+
+private:
+    std::unique_ptr<EventLoop> _loop;
+    std::vector<std::unique_ptr<Channel>> _channels;
+};
+
+
+// TAG: 注册N个fd, 其中一个一直可读, 每次迭代执行一轮事件循环
+template <typename Backend>
+void BM_PollReady(bm::State& state) {
+    const int num_fds = state.range(0);
+    PollerFixture<Backend> fixture(num_fds);
+    fixture.make_readable(num_fds - 1);
+
+    for(auto _ : state) {
+        fixture.loop()->loop_once(0ms);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+// TAG: 每轮开关一次写事件(如发送缓冲区时满时空), 再执行一轮事件循环
+template <typename Backend>
+void BM_UpdateChurn(bm::State& state) {
+    const int num_fds = state.range(0);
+    PollerFixture<Backend> fixture(num_fds);
+    Channel* ch = fixture.channel(0);
+    ch->set_write_callback([] {});
+
+    for(auto _ : state) {
+        ch->set_write_events();
+        fixture.loop()->loop_once(0ms);
+        ch->unset_write_events();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+
+
+// TAG: 注册的N个fd全部一直可读, 每次迭代执行一轮事件循环, 按处理的事件数计算吞吐
+template <typename Backend>
+void BM_PollAllReady(bm::State& state) {
+    const int num_fds = state.range(0);
+    PollerFixture<Backend> fixture(num_fds);
+    for(int i = 0; i < num_fds; ++i) {
+        fixture.make_readable(i);
+    }
+
+    for(auto _ : state) {
+        fixture.loop()->loop_once(0ms);
+    }
+    state.SetItemsProcessed(state.iterations() * num_fds);
+}
+
+} // namespace
+
+BENCHMARK(BM_PollReady<EPollBackend>)
+    ->Name("BM_PollReady/EPoll")
+    ->RangeMultiplier(4)->Range(1, 1024);
+
+BENCHMARK(BM_PollReady<PollBackend>)
+    ->Name("BM_PollReady/Poll")
+    ->RangeMultiplier(4)->Range(1, 1024);
+
+BENCHMARK(BM_UpdateChurn<EPollBackend>)
+    ->Name("BM_UpdateChurn/EPoll")
+    ->RangeMultiplier(4)->Range(1, 1024);
+
+BENCHMARK(BM_UpdateChurn<PollBackend>)
+    ->Name("BM_UpdateChurn/Poll")
+    ->RangeMultiplier(4)->Range(1, 1024);
+
+BENCHMARK(BM_PollAllReady<EPollBackend>)
+    ->Name("BM_PollAllReady/EPoll")
+    ->RangeMultiplier(4)->Range(16, 4096);
+
+BENCHMARK(BM_PollAllReady<PollBackend>)
+    ->Name("BM_PollAllReady/Poll")
+    ->RangeMultiplier(4)->Range(16, 4096);
@@ -48,21 +48,19 @@ private:
         // std::println("write complete: {}", conn->peer_address().ip_port());
     }
 
-    void add_sep(Buffer *buf, std::string &message) {
-        switch (buf->sep()) {
-        case 0:
+    void add_sep(Buffer::SepType sep, Buffer &out) {
+        switch (sep) {
+        case Buffer::None:
             break;
-        
-        case 1: {
-            int len = message.size();
 
-            char tmp[4]{0};
-            memcpy(tmp, &len, 4);
-            message.insert(0, tmp, 4);
+        case Buffer::LengthPrefix: {
+            // 报文头原地写入prependable区域, 不会移动报文内容
+            int32_t len = out.readable();
+            out.prepend(&len, sizeof len);
             break;
         }
-        case 2:
-            message.append("\r\n\r\n");
+        case Buffer::DelimiterSuffix:
+            out.append("\r\n\r\n", 4);
             break;
         }
     }
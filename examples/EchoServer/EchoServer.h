@@ -37,31 +37,32 @@ private:
     }
 
     void onMessage(const TcpConnectionPtr &conn, Buffer *buf, Timestamp time) {
-        std::string msg;
+        std::string_view msg;
         if(buf->pick_datagram(msg)) {
-            add_sep(buf, msg);
-            conn->send(msg);
+            // 先写入报文内容, 报文头在发送前原地补到prependable区域, 不会移动报文内容
+            Buffer out;
+            out.append(msg.data(), msg.size());
+            add_sep(buf->sep(), out);
+            conn->send(&out);
         }
         else {
             std::println("pick_datagram() return false.");
         }
     }
 
-    void add_sep(Buffer *buf, std::string &message) {
-        switch (buf->sep()) {
-        case 0:
+    void add_sep(Buffer::SepType sep, Buffer &out) {
+        switch (sep) {
+        case Buffer::None:
             break;
-        
-        case 1: {
-            int len = message.size();
 
-            char tmp[4]{0};
-            memcpy(tmp, &len, 4);
-            message.insert(0, tmp, 4);
+        case Buffer::LengthPrefix: {
+            // 与 Buffer::pick_datagram 一致, 报文头为主机字节序的4字节长度
+            int32_t len = out.readable();
+            out.prepend(&len, sizeof len);
             break;
         }
-        case 2:
-            message.append("\r\n\r\n");
+        case Buffer::DelimiterSuffix:
+            out.append("\r\n\r\n", 4);
             break;
         }
     }
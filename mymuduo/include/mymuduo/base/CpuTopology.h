@@ -0,0 +1,59 @@
+#ifndef MYMUDUO_BASE_CPUTOPOLOGY_H
+#define MYMUDUO_BASE_CPUTOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+namespace mymuduo {
+
+/**
+ * @brief CPU拓扑: 从sysfs读取每个逻辑CPU所属的物理核, 插槽与NUMA节点
+ *  只包含在线且未被隔离(isolcpus)的CPU
+ */
+class CpuTopology {
+public:
+    struct Cpu {
+        int id = 0;         // 逻辑CPU编号
+        int core = 0;       // 插槽内的物理核编号(超线程共享同一个core)
+        int package = 0;    // 物理插槽
+        int node = 0;       // NUMA节点
+    };
+
+    /**
+     * @brief 探测本机的拓扑, 只保留当前进程的亲和性掩码允许的CPU
+     */
+    static CpuTopology detect();
+
+    /**
+     * @brief 从指定的sysfs目录(默认为 /sys/devices/system)读取拓扑, 不考虑亲和性掩码
+     */
+    static CpuTopology from_sysfs(const std::string& root);
+
+    /**
+     * @brief 解析 "0-3,8,10-11" 格式的CPU列表
+     */
+    static std::vector<int> parse_cpu_list(const std::string& list);
+
+    /**
+     * @brief 将当前线程绑定到cpus上
+     */
+    static bool pin_current_thread(const std::vector<int>& cpus);
+
+    /**
+     * @brief 当前线程之后申请的内存优先从node上分配(set_mempolicy MPOL_PREFERRED)
+     */
+    static bool prefer_memory_node(int node);
+
+    const std::vector<Cpu>& cpus() const { return _cpus; }
+    bool empty() const { return _cpus.empty(); }
+
+    // NUMA节点数, 至少为1
+    int num_nodes() const;
+
+private:
+    std::vector<Cpu> _cpus;     // 按NUMA节点, 插槽, 物理核, CPU编号排序
+};
+
+} // namespace mymuduo
+
+#endif // MYMUDUO_BASE_CPUTOPOLOGY_H
@@ -0,0 +1,120 @@
+#ifndef MYMUDUO_BASE_HISTOGRAM_H
+#define MYMUDUO_BASE_HISTOGRAM_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#include "mymuduo/base/noncopyable.h"
+
+namespace mymuduo {
+
+/**
+ * @brief 无锁的对数分桶直方图
+ *  第0个桶只记录0, 第i个桶记录 [2^(i-1), 2^i) 内的值, 精度为2倍, 足以区分数量级
+ *
+ *  只能有一个写者(如EventLoop线程), 写入只用relaxed的load/store, 没有原子的读改写指令;
+ *  其它线程可以随时获取快照, 快照中各字段之间不保证严格一致
+ */
+class Histogram : noncopyable {
+public:
+    static constexpr std::size_t kBuckets = 64;
+
+    /**
+     * @brief 直方图的快照, 可以合并多个直方图的快照
+     */
+    struct Snapshot {
+        std::array<uint64_t, kBuckets> buckets { };
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+
+        void merge(const Snapshot& other) {
+            for(std::size_t i = 0; i < kBuckets; ++i) {
+                buckets[i] += other.buckets[i];
+            }
+            count += other.count;
+            sum += other.sum;
+            max = std::max(max, other.max);
+        }
+
+        double mean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+
+        /**
+         * @brief 近似的分位数, 返回所在桶的上界(不超过max)
+         * @param p 取值范围 [0, 1]
+         */
+        uint64_t percentile(double p) const {
+            uint64_t total = 0;
+            for(uint64_t n : buckets) {
+                total += n;
+            }
+            if(total == 0) {
+                return 0;
+            }
+
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(p * total + 0.5));
+            uint64_t seen = 0;
+            for(std::size_t i = 0; i < kBuckets; ++i) {
+                seen += buckets[i];
+                if(seen >= rank) {
+                    return std::min(bucket_upper(i), max);
+                }
+            }
+            return max;
+        }
+    };
+
+    /**
+     * @brief 记录一个值, 只能在唯一的写者线程中调用
+     */
+    void record(uint64_t value) {
+        add(_buckets[bucket_index(value)], 1);
+        add(_count, 1);
+        add(_sum, value);
+        if(value > _max.load(std::memory_order_relaxed)) {
+            _max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 获取快照, 可以在任意线程中调用
+     */
+    Snapshot snapshot() const {
+        Snapshot s;
+        for(std::size_t i = 0; i < kBuckets; ++i) {
+            s.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+        }
+        s.count = _count.load(std::memory_order_relaxed);
+        s.sum = _sum.load(std::memory_order_relaxed);
+        s.max = _max.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    static std::size_t bucket_index(uint64_t value) {
+        return std::min<std::size_t>(std::bit_width(value), kBuckets - 1);
+    }
+
+    // 第i个桶中的最大值
+    static uint64_t bucket_upper(std::size_t index) {
+        return index == 0 ? 0 : (index >= kBuckets - 1 ? UINT64_MAX : (uint64_t(1) << index) - 1);
+    }
+
+private:
+    static void add(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBuckets> _buckets { };
+    std::atomic<uint64_t> _count { 0 };
+    std::atomic<uint64_t> _sum { 0 };
+    std::atomic<uint64_t> _max { 0 };
+};
+
+} // namespace mymuduo
+
+#endif // MYMUDUO_BASE_HISTOGRAM_H
@@ -0,0 +1,156 @@
+#ifndef MYMUDUO_BASE_MPSCQUEUE_H
+#define MYMUDUO_BASE_MPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+#include "mymuduo/base/noncopyable.h"
+
+namespace mymuduo {
+
+/**
+ * @brief 无锁的多生产者单消费者队列
+ *  生产者只用一次原子交换把节点挂到链尾, 不会互相阻塞; 只能有一个消费者(如EventLoop线程)
+ *
+ *  节点的回收: 消费者把取空的节点压入本队列的空闲链表, 生产者需要节点时从中出栈一个;
+ *  同一时刻只有一个生产者出栈(其它生产者不等待, 直接申请新节点), 故不存在ABA问题
+ */
+template <typename T>
+class MpscQueue : noncopyable {
+public:
+    // 空闲链表最多缓存的节点数
+    static constexpr std::size_t kMaxFreeNodes = 1024;
+
+    MpscQueue() : _head(new Node), _tail(_head.load(std::memory_order_relaxed)) { }
+
+    /**
+     * @brief 析构时不能再有生产者
+     */
+    ~MpscQueue()
+    {
+        delete_list(_tail);
+        delete_list(_free.load(std::memory_order_acquire));
+    }
+
+    /**
+     * @brief 入队, 可以在任意线程中调用
+     */
+    void push(T value) {
+        emplace(std::move(value));
+    }
+
+    /**
+     * @brief 在节点中直接构造元素, 可以在任意线程中调用
+     */
+    template <typename... Args>
+    void emplace(Args&&... args)
+    {
+        Node* node = acquire_node();
+        node->value.emplace(std::forward<Args>(args)...);
+        node->next.store(nullptr, std::memory_order_relaxed);
+
+        _size.fetch_add(1, std::memory_order_relaxed);
+
+        // MARK: 交换和链接之间, 消费者会暂时看不到该节点及其后的节点,
+        //       但生产者在链接之后才会唤醒消费者, 不会丢失任务
+        Node* prev = _head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * @brief 出队, 只能在消费者线程中调用
+     * @return 队列为空(或队首的节点还未链接完成)时返回false
+     */
+    bool pop(T& value)
+    {
+        Node* tail = _tail;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if(next == nullptr) {
+            return false;
+        }
+
+        // 取出值后next成为新的哨兵节点, 原哨兵节点被回收
+        value = std::move(*next->value);
+        next->value.reset();
+        _tail = next;
+
+        _size.fetch_sub(1, std::memory_order_relaxed);
+        release_node(tail);
+        return true;
+    }
+
+    // 近似的元素个数, 可能包含正在入队的元素
+    std::size_t size() const { return _size.load(std::memory_order_relaxed); }
+    bool empty() const { return size() == 0; }
+
+    // 空闲链表中近似的节点数
+    std::size_t free_nodes() const { return _free_count.load(std::memory_order_relaxed); }
+
+private:
+    struct Node {
+        std::atomic<Node*> next { nullptr };
+        std::optional<T> value;
+    };
+
+    Node* acquire_node()
+    {
+        // MARK: 出栈之间不会交错, 栈顶的节点只能被自己取走, 不会被复用或释放, 读取它的next是安全的;
+        //       与消费者的入栈并发时CAS失败, 按新的栈顶重试
+        if(!_free_popping.test_and_set(std::memory_order_acquire)) {
+            Node* top = _free.load(std::memory_order_acquire);
+            while(top != nullptr && !_free.compare_exchange_weak(top, top->next.load(std::memory_order_relaxed),
+                                                                  std::memory_order_acquire, std::memory_order_acquire)) { }
+            _free_popping.clear(std::memory_order_release);
+
+            if(top != nullptr) {
+                _free_count.fetch_sub(1, std::memory_order_relaxed);
+                return top;
+            }
+        }
+        return new Node;
+    }
+
+    void release_node(Node* node)
+    {
+        // 计数只是近似值, 用于限制空闲链表的长度; 入栈前先计数, 出栈时的减法不会下溢
+        if(_free_count.load(std::memory_order_relaxed) >= kMaxFreeNodes) {
+            delete node;
+            return;
+        }
+        _free_count.fetch_add(1, std::memory_order_relaxed);
+
+        Node* top = _free.load(std::memory_order_relaxed);
+        do {
+            node->next.store(top, std::memory_order_relaxed);
+        } while(!_free.compare_exchange_weak(top, node, std::memory_order_release,
+                                                        std::memory_order_relaxed));
+    }
+
+    static void delete_list(Node* node) {
+        while(node != nullptr) {
+            Node* next = node->next.load(std::memory_order_relaxed);
+            delete node;
+            node = next;
+        }
+    }
+
+private:
+    // 生产者一侧: 最后入队的节点
+    alignas(64) std::atomic<Node*> _head;
+
+    // 消费者一侧: 哨兵节点, 其next为队首元素
+    alignas(64) Node* _tail;
+
+    std::atomic<std::size_t> _size { 0 };
+
+    // 消费者回收的空闲节点
+    alignas(64) std::atomic<Node*> _free { nullptr };
+    std::atomic<std::size_t> _free_count { 0 };
+    std::atomic_flag _free_popping;     // 有生产者正在出栈, 默认为清除状态
+};
+
+} // namespace mymuduo
+
+#endif // MYMUDUO_BASE_MPSCQUEUE_H
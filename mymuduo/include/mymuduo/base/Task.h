@@ -0,0 +1,127 @@
+#ifndef MYMUDUO_BASE_TASK_H
+#define MYMUDUO_BASE_TASK_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace mymuduo {
+
+/**
+ * @brief 只能移动的 void() 可调用对象
+ *  与 std::function 相比内联存储更大(kInlineSize), 捕获了 shared_ptr 和 std::string 的lambda
+ *  也不需要申请堆内存; 超过内联大小的对象才退化为堆上分配
+ *  不要求被包装的对象可拷贝, 故可以捕获 unique_ptr 等只能移动的对象
+ */
+class Task {
+public:
+    static constexpr std::size_t kInlineSize = 64;
+
+    Task() noexcept = default;
+    Task(std::nullptr_t) noexcept { }
+
+    template <typename F,
+              typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same_v<Fn, Task> && std::is_invocable_v<Fn&>>>
+    Task(F&& func)
+    {
+        if constexpr (kStoredInline<Fn>) {
+            ::new (static_cast<void*>(_storage)) Fn(std::forward<F>(func));
+            _ops = &kInlineOps<Fn>;
+        }
+        else {
+            ::new (static_cast<void*>(_storage)) Fn*(new Fn(std::forward<F>(func)));
+            _ops = &kHeapOps<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept {
+        move_from(other);
+    }
+
+    Task& operator= (Task&& other) noexcept {
+        if(this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    Task& operator= (std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator= (const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    void operator() () { _ops->invoke(_storage); }
+
+    explicit operator bool() const noexcept { return _ops != nullptr; }
+
+    /**
+     * @brief 被包装的对象是否存放在内联存储中(不需要堆内存)
+     */
+    bool is_inline() const noexcept { return _ops != nullptr && _ops->is_inline; }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src) noexcept;   // 移动到dst并析构src
+        void (*destroy)(void* storage) noexcept;
+        bool is_inline;
+    };
+
+    template <typename Fn>
+    static constexpr bool kStoredInline = sizeof(Fn) <= kInlineSize
+                                        && alignof(Fn) <= alignof(std::max_align_t)
+                                        && std::is_nothrow_move_constructible_v<Fn>;
+
+    template <typename Fn>
+    static constexpr Ops kInlineOps = {
+        [](void* s) { (*static_cast<Fn*>(s))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* s) noexcept { static_cast<Fn*>(s)->~Fn(); },
+        true
+    };
+
+    // 堆上的对象只需要转移指针
+    template <typename Fn>
+    static constexpr Ops kHeapOps = {
+        [](void* s) { (**static_cast<Fn**>(s))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn*(*static_cast<Fn**>(src));
+        },
+        [](void* s) noexcept { delete *static_cast<Fn**>(s); },
+        false
+    };
+
+    void move_from(Task& other) noexcept {
+        if(other._ops) {
+            other._ops->move(_storage, other._storage);
+            _ops = other._ops;
+            other._ops = nullptr;
+        }
+    }
+
+    void reset() noexcept {
+        if(_ops) {
+            _ops->destroy(_storage);
+            _ops = nullptr;
+        }
+    }
+
+private:
+    alignas(std::max_align_t) unsigned char _storage[kInlineSize];
+    const Ops* _ops = nullptr;
+};
+
+} // namespace mymuduo
+
+#endif // MYMUDUO_BASE_TASK_H
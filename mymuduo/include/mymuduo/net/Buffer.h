@@ -2,22 +2,34 @@
 #define MYMUDUO_NET_BUFFER_H
 
 #include <string>
+#include <string_view>
+#include <cstdint>
 #include <cstring>
+#include <memory>
 #include <vector>
 
+#include "mymuduo/net/BufferPool.h"
+
 namespace mymuduo {
 namespace net {
 
 class Buffer {
 public:
-    // TODO: 分割符后缀未处理转义!!!
+    // MARK: SepType 是旧的分包方式, 仅为兼容保留: LengthPrefix 的报文头为主机字节序且不限制长度,
+    //       DelimiterSuffix 不处理报文内容中的分割符(不转义);
+    //       新的协议请使用 codec::LengthPrefixCodec(大端序, 限制最大长度)
+    //       或 codec::DelimiterCodec(拒绝包含分割符的报文)
     enum SepType {
         None,               // 无分割符
         LengthPrefix,       // 四字节的报文头
         DelimiterSuffix     // \r\n\r\n
     };
 
-    Buffer(std::size_t prependable_size = 8, std::size_t writable_size = 1024);
+    /**
+     * @param pool 若不为空, 则内存从pool中借出, 且推迟到第一次写入时才申请
+     */
+    Buffer(std::size_t prependable_size = 8, std::size_t writable_size = 1024,
+           std::shared_ptr<BufferPool> pool = nullptr);
     Buffer(const Buffer& other);
     Buffer(Buffer&& other) noexcept;
     Buffer& operator= (const Buffer& other);
@@ -27,6 +39,11 @@ public:
      * @brief 分散读和集中写
      */
     std::size_t read_fd(int fd, int* save_errno);
+
+    /**
+     * @brief 使用外部提供的临时缓冲区承接溢出的数据, 如EventLoop的共享读缓冲
+     */
+    std::size_t read_fd(int fd, int* save_errno, char* extrabuf, std::size_t extrabuf_size);
     std::size_t write_fd(int fd, int* save_errno);
 
 
@@ -36,22 +53,87 @@ public:
     void append(const char* data, std::size_t size);
     void append(const std::string& msg);
 
-    char* begin() { return &*_buf.begin(); }
-    const char* cbegin() const { return &*_buf.begin(); }
+    /**
+     * @brief 将数据写入readable区域之前的prependable区域, 用于在报文内容序列化完成后
+     *  原地补上报文头, 不需要移动报文内容; len不能超过 prependable()
+     */
+    void prepend(const void* data, std::size_t len);
+
+    /**
+     * @brief 以网络字节序写入整数报文头
+     */
+    void prepend_int16(uint16_t x);
+    void prepend_int32(uint32_t x);
+    void prepend_int64(uint64_t x);
+
+    char* begin() { return _buf.data(); }
+    const char* cbegin() const { return _buf.data(); }
 
-    char* end() { return &*_buf.end(); }
-    const char* cend() const { return &*_buf.end(); }
+    char* end() { return _buf.data() + _buf.size(); }
+    const char* cend() const { return _buf.data() + _buf.size(); }
+
+    // readable区域的起始位置
+    const char* peek() const { return _buf.data() + _read_idx; }
 
     // 从 readable 区域中删除
     std::string erase(std::size_t size);
 
     void resize(std::size_t len);
 
+    /**
+     * @brief 缓冲区为空时, 将内存全部归还(给内存池), 下一次写入时再重新申请
+     * @return 是否归还成功
+     */
+    bool release();
+    bool released() const { return _buf.empty(); }
+
+    /**
+     * @brief 将缓冲区收缩为 prependable + readable + reserve 的大小(绑定内存池时向上取整到块大小), 用于大报文过后回收内存
+     */
+    void shrink(std::size_t reserve);
+
+    /**
+     * @brief 缓冲区实际占用的内存大小, 绑定内存池时即借出的块大小
+     */
+    std::size_t capacity() const { return _buf.capacity(); }
+    std::size_t initial_size() const { return _initial_prependable + _initial_writable; }
+
     /**
      * @brief 从buf中取出一个报文
+     *  DelimiterSuffix 模式下会记录已扫描过的位置, 报文分多次到达时不会重复扫描
      */
     bool pick_datagram(std::string& msg);
 
+    /**
+     * @brief 从buf中取出一个报文, 不拷贝报文内容
+     *  msg指向缓冲区内部, 只在缓冲区下一次被修改(append, read_fd等)、释放(release)或收缩(shrink)之前有效;
+     *  在 TcpConnection 的消息回调中即只在回调返回之前有效, 需要保留时应拷贝
+     */
+    bool pick_datagram(std::string_view& msg);
+
+    /**
+     * @brief 在readable区域中查找分割符, 返回其相对read_idx的偏移, 未找到返回npos
+     *  会记录扫描断点, 数据分多次到达时不会重复扫描; 断点只属于最近一次查找的分割符; 不移动索引
+     */
+    std::size_t search(std::string_view delim);
+
+    /**
+     * @brief 一次性取出缓冲区中所有完整的报文, 对每个报文调用 func(std::string_view)
+     *  报文视图的有效期与 pick_datagram(std::string_view&) 相同, func中不能修改、释放或收缩该缓冲区
+     * @return 取出的报文个数
+     */
+    template <typename Func>
+    std::size_t for_each_datagram(Func&& func) {
+        std::size_t count = 0;
+        Frame frame;
+        while(find_datagram(frame)) {
+            func(std::string_view{ begin() + _read_idx + frame.body_offset, frame.body_len });
+            retrieve(frame.frame_len);
+            ++count;
+        }
+        return count;
+    }
+
     /**
      * @brief 移动 read_idx, 用于取出数据后
      */
@@ -73,12 +155,35 @@ public:
     /**
      * @brief 获取缓冲区三个区域的大小
      */
-    std::size_t prependable() { return _read_idx; }
-    std::size_t readable()    { return _write_idx - _read_idx; }
-    std::size_t writable()    { return _buf.size() - _write_idx; }
+    std::size_t prependable() const { return _read_idx; }
+    std::size_t readable()    const { return _write_idx - _read_idx; }
+    std::size_t writable()    const { return _buf.size() > _write_idx ? _buf.size() - _write_idx : 0; }
     SepType sep() { return _sep; }
     void set_sep(SepType sep) { _sep = sep; }
 
+private:
+    // 报文在readable区域中的位置
+    struct Frame {
+        std::size_t body_offset;    // 报文内容相对read_idx的偏移(跳过报文头)
+        std::size_t body_len;       // 报文内容的长度
+        std::size_t frame_len;      // 报文在缓冲区中占用的总长度(含报文头或分割符)
+    };
+
+    /**
+     * @brief 查找readable区域开头的完整报文, 不移动索引
+     */
+    bool find_datagram(Frame& frame);
+
+    /**
+     * @brief 实际申请的大小, 绑定内存池时向上取整到内存池的块大小
+     */
+    std::size_t alloc_size(std::size_t size) const;
+
+    /**
+     * @brief 将缓冲区扩大到至少size, 绑定内存池时按整块扩大
+     */
+    void grow(std::size_t size);
+
 private:
     // prependable的初始大小, 也是 read_idx 和 write_idx 的初始值
     std::size_t _initial_prependable;
@@ -89,13 +194,29 @@ private:
     std::size_t _read_idx;
     std::size_t _write_idx;
 
-    // 自动扩容的vector<char>
-    std::vector<char> _buf;
+    // 自动扩容的vector<char>, 内存从所属EventLoop的内存池中借出
+    std::vector<char, PoolAllocator<char>> _buf;
 
     // 分割类型
     SepType _sep = None;
+
+    // 分割符的扫描断点(相对于 read_idx), 该位置之前不存在分割符的起始字节
+    std::size_t _scan_offset = 0;
+
+    // 扫描断点所属的分割符
+    std::string _scan_delim;
 };
 
+namespace __detail {
+
+/**
+ * @brief 在[begin, end)中查找 "\r\n\r\n", 返回其起始位置, 未找到返回nullptr
+ *  运行时按CPU支持情况选择 AVX2 / SSE2 / 标量实现
+ */
+const char* find_crlfcrlf(const char* begin, const char* end);
+
+} // namespace __detail
+
 } // namespace net
 } // namespace mymuduo
 
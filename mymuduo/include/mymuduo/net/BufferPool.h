@@ -0,0 +1,115 @@
+#ifndef MYMUDUO_NET_BUFFERPOOL_H
+#define MYMUDUO_NET_BUFFERPOOL_H
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <sys/types.h>
+
+#include "mymuduo/base/noncopyable.h"
+
+namespace mymuduo {
+namespace net {
+
+/**
+ * @brief 按大小分级的缓冲区内存池, 每个EventLoop拥有一个
+ *  连接的输入输出缓冲区从这里借出内存, 释放时归还到对应级别的空闲链表中
+ *  只有owner线程会访问空闲链表; 其它线程申请或归还时直接走 operator new/delete
+ */
+class BufferPool : noncopyable {
+public:
+    // 最小与最大的级别: 1KB ~ 1MB, 按2的幂划分
+    static constexpr std::size_t kMinClassShift = 10;
+    static constexpr std::size_t kMaxClassShift = 20;
+    static constexpr std::size_t kNumClasses = kMaxClassShift - kMinClassShift + 1;
+
+    static constexpr std::size_t kMinBlockSize = std::size_t(1) << kMinClassShift;
+    static constexpr std::size_t kMaxBlockSize = std::size_t(1) << kMaxClassShift;
+
+    // 每个级别最多缓存的字节数
+    static constexpr std::size_t kMaxCachedBytesPerClass = 4 * 1024 * 1024;
+
+public:
+    explicit BufferPool(pid_t owner_tid);
+    ~BufferPool();
+
+    /**
+     * @brief 申请至少size字节的内存, 实际大小向上取整到所在级别
+     */
+    void* allocate(std::size_t size);
+
+    /**
+     * @brief 归还内存, size须与申请时相同
+     */
+    void deallocate(void* p, std::size_t size);
+
+    /**
+     * @brief size所在级别的块大小, 超过最大级别时原样返回
+     */
+    static std::size_t block_size(std::size_t size);
+
+    /**
+     * @brief 空闲链表中缓存的总字节数
+     */
+    std::size_t cached_bytes() const { return _cached_bytes; }
+
+private:
+    static std::size_t class_index(std::size_t size);
+    bool in_owner_thread() const;
+
+private:
+    const pid_t _owner_tid;
+
+    std::vector<void*> _free_lists[kNumClasses];
+    std::size_t _cached_bytes = 0;
+};
+
+/**
+ * @brief 从BufferPool中申请内存的分配器, 未绑定内存池时退化为 operator new/delete
+ *  持有内存池的shared_ptr, 保证缓冲区析构前内存池不会被释放
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+public:
+    PoolAllocator() noexcept = default;
+    PoolAllocator(std::shared_ptr<BufferPool> pool) noexcept : _pool(std::move(pool)) { }
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) noexcept : _pool(other.pool()) { }
+
+    T* allocate(std::size_t n) {
+        if(_pool) {
+            return static_cast<T*>(_pool->allocate(n * sizeof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if(_pool) {
+            _pool->deallocate(p, n * sizeof(T));
+        }
+        else {
+            ::operator delete(p);
+        }
+    }
+
+    const std::shared_ptr<BufferPool>& pool() const noexcept { return _pool; }
+
+    template <typename U>
+    bool operator== (const PoolAllocator<U>& other) const noexcept { return _pool == other.pool(); }
+
+private:
+    std::shared_ptr<BufferPool> _pool;
+};
+
+} // namespace net
+} // namespace mymuduo
+
+#endif // MYMUDUO_NET_BUFFERPOOL_H
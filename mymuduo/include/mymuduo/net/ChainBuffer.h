@@ -0,0 +1,137 @@
+#ifndef MYMUDUO_NET_CHAINBUFFER_H
+#define MYMUDUO_NET_CHAINBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "mymuduo/base/noncopyable.h"
+#include "mymuduo/net/BufferPool.h"
+
+namespace mymuduo {
+namespace net {
+
+/**
+ * @brief 链式输出缓冲区
+ *  由固定大小的内存块串联而成, 追加数据时只会写入尾部的块, 不会像 Buffer 那样
+ *  因为扩容而整体 memmove 或 realloc; 发送时用 writev 一次性提交多个块
+ */
+class ChainBuffer : noncopyable {
+public:
+    // 每个内存块的大小
+    static constexpr std::size_t kBlockSize = 16 * 1024;
+
+    // 单次 writev 最多提交的块数
+    static constexpr int kMaxIovecs = 64;
+
+    // 未绑定内存池时最多缓存的空闲块数, 避免频繁的 malloc/free
+    static constexpr std::size_t kMaxSpareBlocks = 2;
+
+public:
+    /**
+     * @param pool 内存块的来源, 为空时直接从堆上申请
+     */
+    explicit ChainBuffer(std::shared_ptr<BufferPool> pool = nullptr);
+    ChainBuffer(ChainBuffer&& other) noexcept;
+    ChainBuffer& operator= (ChainBuffer&& other) noexcept;
+    ~ChainBuffer();
+
+    /**
+     * @brief 将数据拷贝到链尾, 尾块写满后自动追加新块
+     */
+    void append(const char* data, std::size_t size);
+    void append(const std::string& msg);
+
+    /**
+     * @brief 集中写, 将尽可能多的块通过一次 writev 写入fd
+     * @param max_len 最多写入的字节数, 用于只发送排在某个文件之前的数据
+     */
+    ssize_t write_fd(int fd, int* save_errno, std::size_t max_len = SIZE_MAX);
+
+    /**
+     * @brief 将链首起最多 kMaxIovecs 个块中的待发送数据(最多max_len字节)填入iov, 并锁定这些块,
+     *  用于一次提交多段内存的异步发送(如 IORING_OP_SENDMSG);
+     *  返回的句柄存活期间块不会被释放或复用, 即使数据已被retrieve, 或者ChainBuffer已经析构,
+     *  因为内核在请求完成(零拷贝时为完成通知)之前仍会读取块中的内存
+     * @param iov 至少能容纳 kMaxIovecs 项
+     * @return 所有块的锁定句柄, iov_count为填入的项数; 链为空时返回空
+     */
+    std::shared_ptr<const void> pin_iovecs(struct iovec* iov, int* iov_count, std::size_t max_len = SIZE_MAX);
+
+    /**
+     * @brief 丢弃链首的len字节数据
+     */
+    void retrieve(std::size_t len);
+    void retrieve_all();
+    std::string retrieve_all_as_string();
+
+    /**
+     * @brief 释放缓存的空闲块; 读空的块在 retrieve 时就已释放, 绑定内存池时不会缓存空闲块
+     */
+    void shrink();
+
+    std::size_t readable() const { return _readable; }
+    std::size_t num_blocks() const { return _blocks.size(); }
+    std::size_t capacity() const { return (_blocks.size() + _spare.size()) * kBlockSize; }
+    bool empty() const { return _readable == 0; }
+
+private:
+    // 被锁定的块, 由最后一个持有者归还内存
+    struct PinnedBlock : noncopyable {
+        PinnedBlock(std::shared_ptr<BufferPool> pool, char* data) : pool(std::move(pool)), data(data) { }
+        ~PinnedBlock();
+
+        std::shared_ptr<BufferPool> pool;
+        char* data;
+    };
+
+    struct Block {
+        char* data = nullptr;
+        std::size_t read_idx = 0;
+        std::size_t write_idx = 0;
+        std::shared_ptr<PinnedBlock> pinned;    // 不为空时内存由它归还
+
+        std::size_t readable() const { return write_idx - read_idx; }
+        std::size_t writable() const { return kBlockSize - write_idx; }
+    };
+
+    /**
+     * @brief 在链尾追加一个空块, 优先复用空闲块
+     */
+    Block& new_block();
+
+    /**
+     * @brief 释放链首的块, 将其放回空闲列表或内存池
+     */
+    void pop_block();
+
+    /**
+     * @brief 按顺序将链首的块填入iov, pins不为空时同时锁定填入的块
+     * @return 填入的项数
+     */
+    int fill_iovecs(struct iovec* iov, std::size_t max_len, std::vector<std::shared_ptr<PinnedBlock>>* pins = nullptr);
+
+    char* allocate_block();
+    void deallocate_block(char* data);
+    void clear();
+
+private:
+    std::shared_ptr<BufferPool> _pool;
+
+    std::deque<Block> _blocks;
+    std::vector<char*> _spare;
+
+    // 所有块中待发送数据的总大小
+    std::size_t _readable = 0;
+};
+
+} // namespace net
+} // namespace mymuduo
+
+#endif // MYMUDUO_NET_CHAINBUFFER_H
@@ -76,8 +76,8 @@ public:
     void set_error_callback(EventCallback cb); // 错误事件
 
     bool is_none_events() { return _monitored_events == _none_events; }
-    bool is_reading() { return _monitored_events == _read_events; }
-    bool is_writing() { return _monitored_events == _write_events; }
+    bool is_reading() { return _monitored_events & _read_events; }
+    bool is_writing() { return _monitored_events & _write_events; }
 
     /**
      * @brief 将channel与obj绑定在一起, 在TcpConnection建立时绑定
@@ -87,6 +87,10 @@ public:
     channelStatus  get_status() { return _status; }
     void set_status(channelStatus status) { _status = status; }
 
+    // 在Poller内部数组中的下标, 由使用数组的Poller(如PollPoller)维护, -1表示不在数组中
+    int index() const { return _index; }
+    void set_index(int index) { _index = index; }
+
     int fd();
     EventLoop* owner_loop() { return _loop_ptr; }
 
@@ -105,6 +109,7 @@ private:
     uint32_t _monitored_events = 0;
     uint32_t _happened_events = 0;
     channelStatus _status;           // channel在Poller中的状态(未添加, 已添加, 已删除)
+    int _index = -1;
 
     /**
      * 用于保存channel和其绑定对象的弱引用, 绑定对象通常是TcpConnection
@@ -0,0 +1,72 @@
+#ifndef MYMUDUO_NET_CHANNELTABLE_H
+#define MYMUDUO_NET_CHANNELTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mymuduo {
+namespace net {
+
+class Channel;
+
+/**
+ * @brief 以fd为下标的Channel表, 替代 unordered_map<int, Channel*>
+ *  Linux分配的fd是从小到大连续复用的整数, 直接用数组下标查找, 不需要哈希, 每个fd只占一个槽位
+ *
+ *  每个槽位带有一个代数(generation), 每次注册时加一, 删除后仍然保留;
+ *  fd被关闭后又被新的Channel复用时代数不同, 持有旧代数的事件(如epoll中残留的注册)可以被识别并丢弃
+ */
+class ChannelTable {
+public:
+    /**
+     * @brief 注册ch, 覆盖fd上原有的Channel, 数组不够大时扩容
+     * @return 本次注册的代数
+     */
+    uint32_t insert(Channel *ch);
+
+    /**
+     * @brief 清空fd的槽位, 保留其代数
+     */
+    void erase(int fd);
+
+    Channel* find(int fd) const {
+        return fd >= 0 && static_cast<std::size_t>(fd) < _slots.size() ? _slots[fd].ch : nullptr;
+    }
+
+    /**
+     * @brief 查找fd上代数为generation的Channel, 已被删除或fd已被复用时返回nullptr
+     */
+    Channel* find(int fd, uint32_t generation) const {
+        Channel* ch = find(fd);
+        return ch != nullptr && _slots[fd].generation == generation ? ch : nullptr;
+    }
+
+    // fd当前(或最近一次)注册的代数
+    uint32_t generation(int fd) const {
+        return fd >= 0 && static_cast<std::size_t>(fd) < _slots.size() ? _slots[fd].generation : 0;
+    }
+
+    bool contains(Channel *ch) const;
+
+    // 已注册的Channel个数
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    // 槽位数, 即目前见过的最大fd + 1
+    std::size_t capacity() const { return _slots.size(); }
+
+private:
+    struct Slot {
+        Channel* ch = nullptr;
+        uint32_t generation = 0;
+    };
+
+    std::vector<Slot> _slots;   // 下标: fd
+    std::size_t _size = 0;
+};
+
+} // namespace net
+} // namespace mymuduo
+
+#endif // MYMUDUO_NET_CHANNELTABLE_H
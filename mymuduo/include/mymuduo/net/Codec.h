@@ -0,0 +1,327 @@
+#ifndef MYMUDUO_NET_CODEC_H
+#define MYMUDUO_NET_CODEC_H
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "mymuduo/base/Logger.h"
+#include "mymuduo/base/Timestamp.h"
+#include "mymuduo/net/Buffer.h"
+#include "mymuduo/net/callbacks.h"
+#include "mymuduo/net/TcpConnection.h"
+
+namespace mymuduo {
+namespace net {
+namespace codec {
+
+/**
+ * 报文编解码器
+ *  每种分帧方式是一个独立的类型, 通过模板静态分发, 解码逻辑可以被内联进消息回调中,
+ *  不再需要 Buffer::SepType 那样的运行时switch
+ *
+ *  解码: 在 buf 的 readable 区域开头查找一个完整的报文, 不移动索引;
+ *        body 指向报文内容, frame_len 为报文在缓冲区中占用的总长度
+ *  编码: 将报文(及报文头或分割符)追加到任何提供 append(const char*, size_t) 的对象中
+ */
+enum class DecodeStatus {
+    kComplete,      // 得到一个完整的报文
+    kIncomplete,    // 报文不完整, 等待更多数据
+    kError          // 报文非法(超过最大长度, 报文头错误等), 应关闭连接
+};
+
+template <typename Codec>
+concept FramingCodec = requires(const Codec codec, Buffer& buf, std::string_view body,
+                                std::size_t& frame_len, std::string& out)
+{
+    { codec.decode(buf, body, frame_len) } -> std::same_as<DecodeStatus>;
+    { codec.encode(body, out) } -> std::same_as<bool>;
+};
+
+// 默认的最大报文长度
+inline constexpr std::size_t kDefaultMaxFrameSize = 64 * 1024 * 1024;
+
+
+/**
+ * @brief 定长的大端序报文头, HeaderBytes 为 2, 4 或 8
+ */
+template <std::size_t HeaderBytes>
+class LengthPrefixCodec {
+    static_assert(HeaderBytes == 2 || HeaderBytes == 4 || HeaderBytes == 8,
+                  "length prefix must be 2, 4 or 8 bytes");
+
+public:
+    static constexpr std::size_t kHeaderBytes = HeaderBytes;
+
+    explicit LengthPrefixCodec(std::size_t max_frame_size = kDefaultMaxFrameSize)
+        : _max_frame_size(max_frame_size) { }
+
+    DecodeStatus decode(Buffer& buf, std::string_view& body, std::size_t& frame_len) const {
+        if(buf.readable() < kHeaderBytes) {
+            return DecodeStatus::kIncomplete;
+        }
+
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(buf.peek());
+        uint64_t len = 0;
+        for(std::size_t i = 0; i < kHeaderBytes; ++i) {
+            len = (len << 8) | p[i];
+        }
+
+        if(len > _max_frame_size) {
+            return DecodeStatus::kError;
+        }
+        if(buf.readable() < kHeaderBytes + len) {
+            return DecodeStatus::kIncomplete;
+        }
+
+        body = { buf.peek() + kHeaderBytes, static_cast<std::size_t>(len) };
+        frame_len = kHeaderBytes + len;
+        return DecodeStatus::kComplete;
+    }
+
+    template <typename Output>
+    bool encode(std::string_view body, Output& out) const {
+        if(body.size() > _max_frame_size) {
+            return false;
+        }
+        if constexpr (kHeaderBytes < 8) {   // 8字节的长度字段容纳任何长度, 且移位64位是未定义行为
+            if(body.size() >> (kHeaderBytes * 8)) {
+                return false;
+            }
+        }
+
+        char header[kHeaderBytes];
+        uint64_t len = body.size();
+        for(std::size_t i = kHeaderBytes; i > 0; --i) {
+            header[i - 1] = static_cast<char>(len & 0xff);
+            len >>= 8;
+        }
+
+        out.append(header, kHeaderBytes);
+        out.append(body.data(), body.size());
+        return true;
+    }
+
+    std::size_t max_frame_size() const { return _max_frame_size; }
+
+private:
+    std::size_t _max_frame_size;
+};
+
+
+/**
+ * @brief 变长(varint, LEB128)编码的报文头, 每个字节的低7位为数据, 最高位表示后面还有字节
+ */
+class VarintLengthCodec {
+public:
+    static constexpr std::size_t kMaxHeaderBytes = 10;
+
+    explicit VarintLengthCodec(std::size_t max_frame_size = kDefaultMaxFrameSize)
+        : _max_frame_size(max_frame_size) { }
+
+    DecodeStatus decode(Buffer& buf, std::string_view& body, std::size_t& frame_len) const {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(buf.peek());
+        const std::size_t readable = buf.readable();
+
+        uint64_t len = 0;
+        std::size_t header = 0;
+        while(true) {
+            if(header == readable) {
+                return DecodeStatus::kIncomplete;
+            }
+            if(header == kMaxHeaderBytes) {
+                return DecodeStatus::kError;
+            }
+
+            // 第10个字节只剩最低位(第63位)可用, 更高的位会被移出, 视为长度溢出
+            const unsigned char byte = p[header];
+            if(header == kMaxHeaderBytes - 1 && (byte & 0x7e)) {
+                return DecodeStatus::kError;
+            }
+            len |= static_cast<uint64_t>(byte & 0x7f) << (7 * header);
+            ++header;
+
+            if((byte & 0x80) == 0) {
+                break;
+            }
+        }
+
+        if(len > _max_frame_size) {
+            return DecodeStatus::kError;
+        }
+        if(readable < header + len) {
+            return DecodeStatus::kIncomplete;
+        }
+
+        body = { buf.peek() + header, static_cast<std::size_t>(len) };
+        frame_len = header + len;
+        return DecodeStatus::kComplete;
+    }
+
+    template <typename Output>
+    bool encode(std::string_view body, Output& out) const {
+        if(body.size() > _max_frame_size) {
+            return false;
+        }
+
+        char header[kMaxHeaderBytes];
+        std::size_t n = 0;
+        uint64_t len = body.size();
+        do {
+            char byte = static_cast<char>(len & 0x7f);
+            len >>= 7;
+            header[n++] = static_cast<char>(byte | (len ? 0x80 : 0));
+        } while(len);
+
+        out.append(header, n);
+        out.append(body.data(), body.size());
+        return true;
+    }
+
+    std::size_t max_frame_size() const { return _max_frame_size; }
+
+private:
+    std::size_t _max_frame_size;
+};
+
+
+/**
+ * @brief 以分割符结尾的报文, 查找时复用 Buffer 的扫描断点
+ *  分割符不做转义, 编码时拒绝内容中含有分割符的报文, 保证对端不会错误地分帧
+ */
+class DelimiterCodec {
+public:
+    explicit DelimiterCodec(std::string delim = "\r\n\r\n",
+                            std::size_t max_frame_size = kDefaultMaxFrameSize)
+        : _delim(std::move(delim)), _max_frame_size(max_frame_size) { }
+
+    DecodeStatus decode(Buffer& buf, std::string_view& body, std::size_t& frame_len) const {
+        std::size_t len = buf.search(_delim);
+
+        if(len == std::string_view::npos) {
+            // 积累的数据已经超过最大长度还没有找到分割符
+            return buf.readable() > _max_frame_size + _delim.size()
+                        ? DecodeStatus::kError : DecodeStatus::kIncomplete;
+        }
+        if(len > _max_frame_size) {
+            return DecodeStatus::kError;
+        }
+
+        body = { buf.peek(), len };
+        frame_len = len + _delim.size();
+        return DecodeStatus::kComplete;
+    }
+
+    template <typename Output>
+    bool encode(std::string_view body, Output& out) const {
+        if(body.size() > _max_frame_size || body.find(_delim) != std::string_view::npos) {
+            return false;
+        }
+
+        out.append(body.data(), body.size());
+        out.append(_delim.data(), _delim.size());
+        return true;
+    }
+
+    const std::string& delimiter() const { return _delim; }
+    std::size_t max_frame_size() const { return _max_frame_size; }
+
+private:
+    std::string _delim;
+    std::size_t _max_frame_size;
+};
+
+
+/**
+ * @brief 定长报文, 没有报文头和分割符
+ */
+class FixedSizeCodec {
+public:
+    explicit FixedSizeCodec(std::size_t frame_size) : _frame_size(frame_size) { }
+
+    DecodeStatus decode(Buffer& buf, std::string_view& body, std::size_t& frame_len) const {
+        if(buf.readable() < _frame_size) {
+            return DecodeStatus::kIncomplete;
+        }
+
+        body = { buf.peek(), _frame_size };
+        frame_len = _frame_size;
+        return DecodeStatus::kComplete;
+    }
+
+    template <typename Output>
+    bool encode(std::string_view body, Output& out) const {
+        if(body.size() != _frame_size) {
+            return false;
+        }
+
+        out.append(body.data(), body.size());
+        return true;
+    }
+
+    std::size_t frame_size() const { return _frame_size; }
+
+private:
+    std::size_t _frame_size;
+};
+
+
+/**
+ * @brief 将编解码器与报文回调组合为 MessageCallback
+ *  每次读事件只经过一次 std::function 调用, 之后在内联的解码循环中取出所有完整的报文;
+ *  报文非法时关闭连接
+ */
+template <FramingCodec Codec>
+MessageCallback make_message_callback(Codec codec, FrameCallback cb)
+{
+    return [codec = std::move(codec), cb = std::move(cb)]
+           (const TcpConnectionPtr& conn, Buffer* buf, Timestamp receive_time)
+    {
+        std::string_view body;
+        std::size_t frame_len = 0;
+
+        while(true) {
+            DecodeStatus status = codec.decode(*buf, body, frame_len);
+
+            if(status == DecodeStatus::kComplete) {
+                // body 指向缓冲区内部, 在回调返回后才将其取出
+                cb(conn, body, receive_time);
+                buf->retrieve(frame_len);
+            }
+            else if(status == DecodeStatus::kError) {
+                LOG_WARN("TcpConnection {} received an invalid frame, closing.", conn->name());
+                buf->retrieve_all();
+                conn->force_close();
+                break;
+            }
+            else {
+                break;
+            }
+        }
+    };
+}
+
+/**
+ * @brief 编码后发送一个报文
+ * @return 报文不符合编解码器的要求时返回false
+ */
+template <FramingCodec Codec>
+bool send_frame(const Codec& codec, const TcpConnectionPtr& conn, std::string_view body)
+{
+    std::string frame;
+    frame.reserve(body.size() + 16);
+    if(!codec.encode(body, frame)) {
+        return false;
+    }
+
+    conn->send(std::move(frame));
+    return true;
+}
+
+} // namespace codec
+} // namespace net
+} // namespace mymuduo
+
+#endif // MYMUDUO_NET_CODEC_H
@@ -11,9 +11,13 @@
 #include <vector>
 #include <sys/eventfd.h> // 利用eventfd唤醒线程
 
+#include "mymuduo/base/MpscQueue.h"
+#include "mymuduo/base/Task.h"
 #include "mymuduo/base/noncopyable.h"
 #include "mymuduo/base/Timestamp.h"
 #include "mymuduo/base/CurrentThread.h"
+#include "mymuduo/net/BufferPool.h"
+#include "mymuduo/net/EventLoopMetrics.h"
 #include "mymuduo/net/Poller.h"
 #include "mymuduo/net/TimerQueue.h"
 #include "mymuduo/net/callbacks.h"
@@ -35,7 +39,8 @@ class EventLoop : noncopyable
 public:
     
     using ChannelList = std::vector<Channel*>;
-    using Functor = std::function<void()>;
+    // 只能移动的任务, 捕获不超过 Task::kInlineSize 字节的任务不需要堆内存
+    using Functor = Task;
 
 public:
 
@@ -65,16 +70,56 @@ public:
 
     /**
      * @brief 直接执行; 若当前线程是EventLoop所属线程, 则会立即执行, 否则调用queue_in_loop
+     *  在loop线程中直接调用task, 不会构造Functor
      */
-    void run_in_loop(Functor task);
+    template <typename F>
+    void run_in_loop(F&& task) {
+        if(is_loop_thread()) {
+            task();
+        }
+        else {
+            queue_in_loop(std::forward<F>(task));
+        }
+    }
 
     /**
      * @brief 延迟执行; 将任务加入EventLoop所属线程的任务队列中, 并唤醒线程
+     *  任务直接在队列的节点中构造, 不经过中间的Functor
      */
-    void queue_in_loop(Functor task);
+    template <typename F>
+    void queue_in_loop(F&& task) {
+        _task_queue.emplace(std::forward<F>(task));
+        after_queued();
+    }
+
+    /**
+     * @brief 忙轮询模式: 阻塞在poll之前, 先以0超时反复poll至多budget时长, 省去线程被调度唤醒的延迟
+     *  实际的自旋时长在 [0, budget] 之间自适应: 自旋期间等到事件时加倍, 空转到期时减半
+     *  budget为0时关闭; 可以在任意线程中调用, 下一轮poll生效
+     */
+    void set_busy_poll(std::chrono::microseconds budget) {
+        _busy_poll_us.store(budget.count() > 0 ? budget.count() : 0, std::memory_order_relaxed);
+    }
+    std::chrono::microseconds busy_poll() const {
+        return std::chrono::microseconds(_busy_poll_us.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * @brief 每轮循环执行任务队列的预算: 最多执行max_tasks个任务, 或最多执行max_time时长
+     *  超出预算时剩余的任务留到下一轮, 先处理I/O事件; 有剩余任务时poll不会阻塞
+     *  为0表示不限制; 可以在任意线程中调用
+     */
+    void set_task_budget(std::size_t max_tasks, std::chrono::microseconds max_time = 0us) {
+        _task_budget_count.store(max_tasks, std::memory_order_relaxed);
+        _task_budget_us.store(max_time.count() > 0 ? max_time.count() : 0, std::memory_order_relaxed);
+    }
+
+    // 当前自适应的自旋时长, 只能在loop线程中调用
+    std::chrono::microseconds spin_budget() const { return _spin_budget; }
 
     /**
      * @brief 将subLoop从poll()中唤醒过来
+     *  loop没有阻塞在poll中, 或本轮poll已经被唤醒过时, 不会再写eventfd
      */
     void wakeup();
 
@@ -89,11 +134,31 @@ public:
     void update_channel(Channel* ch) { _poller->update_channel(ch); }
     void remove_channel(Channel* ch) { _poller->remove_channel(ch); }
     bool has_channel(Channel* ch) { return _poller->has_channel(ch); }
+    Poller* poller() const { return _poller.get(); }
+
+    /**
+     * @brief 本loop内所有连接共享的读缓冲区, 用于承接 Buffer::read_fd 溢出的数据
+     *        只能在loop线程中使用
+     */
+    char* scratch_buffer() { return _scratch_buffer.get(); }
+
+    /**
+     * @brief 本loop内连接的输入输出缓冲区的内存池
+     */
+    const std::shared_ptr<BufferPool>& buffer_pool() const { return _buffer_pool; }
 
     const pid_t tid() const { return _tid; }
     const bool looping() const { return _looping.load(); }
     const size_t task_queue_size() const { return _task_queue.size(); }
 
+    // 实际写入eventfd的唤醒次数
+    const size_t wakeup_writes() const { return _wakeup_writes.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 运行指标的快照, 可以在任意线程中调用
+     */
+    EventLoopMetrics::Snapshot metrics() const;
+
 private:
 
     /**
@@ -103,13 +168,44 @@ private:
 
     /**
      * @brief 执行任务队列中的任务
+     * @return 执行的任务数
+     */
+    std::size_t do_pending_functors();
+
+    /**
+     * @brief 任务入队后, 按需唤醒loop线程
+     */
+    void after_queued();
+
+    /**
+     * @brief 一轮事件循环: poll, 处理活跃的Channel, 执行任务队列中的任务
+     */
+    void poll_once(std::chrono::system_clock::duration timeout);
+
+    /**
+     * @brief 忙轮询, 并根据结果调整下一轮的自旋时长
+     * @return 自旋期间是否等到了事件或任务; 为false时应继续阻塞poll
+     */
+    bool spin_poll(std::chrono::microseconds max_budget);
+
+    /**
+     * @brief 处理poll返回的活跃Channel, 再执行任务队列中的任务
      */
-    void do_pending_functors();
+    void dispatch_active_channels(std::chrono::steady_clock::time_point poll_start);
 
 public:
     // Poller的默认超时时间
     static constexpr std::chrono::system_clock::duration kPollTimeMs = 10000ms;
 
+    // 设置了时间预算时, 每执行这么多个任务检查一次时间
+    static constexpr std::size_t kTaskBudgetCheckInterval = 16;
+
+    // 忙轮询的自旋时长从0恢复时的起点
+    static constexpr std::chrono::microseconds kMinSpinBudget = 8us;
+
+    // 共享读缓冲区的大小
+    static constexpr std::size_t kScratchBufferSize = 64 * 1024;
+
 private:
 
     /**
@@ -129,10 +225,25 @@ private:
         int _wakeup_fd; // 用于唤醒事件循环的eventfd
         std::unique_ptr<Channel> _wakeup_channel; // 用于将eventfd加入到epoll
 
+        // 唤醒合并: loop即将阻塞在poll中时才需要唤醒, 且每轮poll最多写一次eventfd
+        std::atomic<bool> _polling = false;
+        std::atomic<bool> _wakeup_pending = false;
+        std::atomic<size_t> _wakeup_writes = 0;
+
+        // 每轮执行任务的预算, 0为不限制
+        std::atomic<std::size_t> _task_budget_count = 0;
+        std::atomic<int64_t> _task_budget_us = 0;
+
+        // 每轮循环的耗时, 活跃Channel数与执行的任务数
+        EventLoopMetrics _metrics;
 
-        // IO线程的任务队列, 用来其它线程的任务
-        std::vector<Functor> _task_queue;
-        std::mutex _queue_mutex;   // 任务队列的互斥锁
+        // 忙轮询: 用户设置的自旋上限(微秒, 0为关闭)与当前自适应的自旋时长(只在loop线程中访问)
+        std::atomic<int64_t> _busy_poll_us = 0;
+        std::chrono::microseconds _spin_budget { 0 };
+
+
+        // IO线程的任务队列, 用来其它线程的任务; 无锁, 多个线程投递任务时不会互相阻塞
+        MpscQueue<Functor> _task_queue;
 
     /**
      * Poller
@@ -155,6 +266,12 @@ private:
 
         ChannelList _activeChannels;
 
+        // 所有连接共享的读缓冲区, 只分配一次且不清零
+        std::unique_ptr<char[]> _scratch_buffer;
+
+        // 连接缓冲区的内存池, 缓冲区持有其shared_ptr, 故可以比loop活得更久
+        std::shared_ptr<BufferPool> _buffer_pool;
+
 };
 
 } // namespace net
@@ -0,0 +1,105 @@
+#ifndef MYMUDUO_NET_EVENTLOOPMETRICS_H
+#define MYMUDUO_NET_EVENTLOOPMETRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "mymuduo/base/Histogram.h"
+#include "mymuduo/base/noncopyable.h"
+
+namespace mymuduo {
+namespace net {
+
+/**
+ * @brief EventLoop每轮循环的运行指标
+ *  由loop线程写入, 其它线程通过 snapshot() 读取; 时间的单位均为纳秒
+ *
+ *  用于区分长尾的来源: poll_wait 小而 handle 大说明回调太重, functors 与 drained_tasks 大
+ *  说明任务队列积压, poll_wait 长期接近0且 active_channels 大说明线程数不足
+ */
+class EventLoopMetrics : noncopyable {
+public:
+    struct Snapshot {
+        Histogram::Snapshot poll_wait_ns;       // 在Poller::poll中阻塞(或忙轮询)的时间
+        Histogram::Snapshot handle_ns;          // 处理活跃Channel的时间
+        Histogram::Snapshot functors_ns;        // 执行任务队列的时间
+        Histogram::Snapshot iteration_ns;       // 一轮循环的总时间
+        Histogram::Snapshot active_channels;    // 每轮的活跃Channel数
+        Histogram::Snapshot drained_tasks;      // 每轮执行的任务数
+
+        uint64_t iterations = 0;
+        uint64_t tasks = 0;                     // 执行过的任务总数
+        uint64_t task_backlog = 0;              // 获取快照时任务队列中的任务数
+        uint64_t wakeup_writes = 0;             // 写入eventfd的次数
+        std::size_t loops = 0;                  // 合并了几个loop的指标
+
+        /**
+         * @brief 合并另一个loop的指标, 用于在线程池中汇总
+         */
+        void merge(const Snapshot& other) {
+            poll_wait_ns.merge(other.poll_wait_ns);
+            handle_ns.merge(other.handle_ns);
+            functors_ns.merge(other.functors_ns);
+            iteration_ns.merge(other.iteration_ns);
+            active_channels.merge(other.active_channels);
+            drained_tasks.merge(other.drained_tasks);
+
+            iterations += other.iterations;
+            tasks += other.tasks;
+            task_backlog += other.task_backlog;
+            wakeup_writes += other.wakeup_writes;
+            loops += other.loops;
+        }
+    };
+
+    /**
+     * @brief 记录一轮循环, 只能在loop线程中调用
+     */
+    void record_iteration(std::chrono::nanoseconds poll_wait, std::chrono::nanoseconds handle,
+                          std::chrono::nanoseconds functors, std::size_t active_channels,
+                          std::size_t drained_tasks)
+    {
+        _poll_wait_ns.record(poll_wait.count());
+        _handle_ns.record(handle.count());
+        _functors_ns.record(functors.count());
+        _iteration_ns.record((poll_wait + handle + functors).count());
+        _active_channels.record(active_channels);
+        _drained_tasks.record(drained_tasks);
+
+        _tasks.store(_tasks.load(std::memory_order_relaxed) + drained_tasks, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取快照, 可以在任意线程中调用; task_backlog 和 wakeup_writes 由 EventLoop 填写
+     */
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.poll_wait_ns = _poll_wait_ns.snapshot();
+        s.handle_ns = _handle_ns.snapshot();
+        s.functors_ns = _functors_ns.snapshot();
+        s.iteration_ns = _iteration_ns.snapshot();
+        s.active_channels = _active_channels.snapshot();
+        s.drained_tasks = _drained_tasks.snapshot();
+        s.iterations = s.iteration_ns.count;
+        s.tasks = _tasks.load(std::memory_order_relaxed);
+        s.loops = 1;
+        return s;
+    }
+
+private:
+    Histogram _poll_wait_ns;
+    Histogram _handle_ns;
+    Histogram _functors_ns;
+    Histogram _iteration_ns;
+    Histogram _active_channels;
+    Histogram _drained_tasks;
+
+    std::atomic<uint64_t> _tasks { 0 };
+};
+
+} // namespace net
+} // namespace mymuduo
+
+#endif // MYMUDUO_NET_EVENTLOOPMETRICS_H
@@ -5,6 +5,7 @@
 #include <condition_variable>
 #include <string>
 #include <mutex>
+#include <vector>
 
 #include "mymuduo/base/Thread.h"
 #include "mymuduo/base/noncopyable.h"
@@ -17,6 +18,14 @@ namespace net {
 
 class EventLoop;
 
+/**
+ * @brief loop线程的放置: 绑定的CPU集合与内存优先分配的NUMA节点
+ */
+struct LoopPlacement {
+    std::vector<int> cpus;  // 为空时不绑定
+    int node = -1;          // 为-1时不设置内存策略
+};
+
 /**
  * @brief EventLoop线程: one loop per thread
  */
@@ -39,6 +48,13 @@ public:
 
     void stop_loop();
 
+    /**
+     * @brief 设置线程的放置, 需在start_loop之前调用
+     *  线程启动后, 在创建EventLoop之前绑定CPU和设置内存策略, 故loop及其缓冲区的内存都在本地节点上
+     */
+    void set_placement(LoopPlacement placement) { _placement = std::move(placement); }
+    const LoopPlacement& placement() const { return _placement; }
+
     const bool started() const { return _thread.started(); }
     const bool running() const { return _running.load(); }
     const bool exited() const { return _exited.load(); }
@@ -67,6 +83,8 @@ private:
     std::condition_variable _cond;
 
     ThreadInitCallback _init_callback;
+
+    LoopPlacement _placement;
 };
 
 } // namespace net
@@ -2,18 +2,30 @@
 #define MYMUDUO_NET_EVENTLOOPTHREADPOOL_H
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <vector>
 #include <string>
 
+#include "mymuduo/base/CpuTopology.h"
 #include "mymuduo/base/noncopyable.h"
 #include "mymuduo/net/callbacks.h"
+#include "mymuduo/net/EventLoopMetrics.h"
+#include "mymuduo/net/EventLoopThread.h"
 
 namespace mymuduo {
 namespace net {
 
 class EventLoop;
-class EventLoopThread;
+
+/**
+ * @brief 从loop线程的放置策略
+ */
+enum class PlacementPolicy {
+    kNone,      // 不绑定, 由调度器决定
+    kPerCore,   // 每个loop绑定到一个物理核(含其超线程); 依次轮流从各个NUMA节点取核, loop多于核时循环复用
+    kPerNode    // 每个loop绑定到一个NUMA节点的全部CPU, loop在节点间轮流分配
+};
 
 /**
  * @brief EventLoop线程池, 每个服务器都要有该对象
@@ -36,11 +48,46 @@ public:
 
     std::vector<EventLoop*> get_all_loops();
 
+    /**
+     * @brief 汇总所有loop(没有从loop, 或者已经stop时为main_loop)的运行指标
+     *  与 get_all_loops 相同, 只能在调用 start/stop 的线程(通常是main_loop线程)中调用
+     */
+    EventLoopMetrics::Snapshot metrics();
+
+    /**
+     * @brief 设置从loop的忙轮询时长(见 EventLoop::set_busy_poll), 0为关闭
+     *  不指定index时作用于所有从loop; 可以在start之前或之后调用
+     *  没有从loop时, index为0的设置作用于main_loop
+     */
+    void set_busy_poll(std::chrono::microseconds budget);
+    void set_busy_poll(int index, std::chrono::microseconds budget);
+
+    /**
+     * @brief 从loop线程的放置策略, 需在start之前调用
+     *  线程会在创建EventLoop之前绑定CPU, 并让其内存优先从所在的NUMA节点分配,
+     *  连接缓冲区在loop线程中第一次使用时才申请, 故也位于loop所在的节点
+     */
+    void set_placement(PlacementPolicy policy) { _placement = policy; }
+    PlacementPolicy placement() const { return _placement; }
+
+    /**
+     * @brief 按策略为num_loops个loop分配CPU, 已隔离(isolcpus)的CPU不在topo中, 不会被分配
+     */
+    static std::vector<LoopPlacement> plan_placement(const CpuTopology& topo, PlacementPolicy policy,
+                                                     int num_loops);
+
     void set_thread_num(int num) { _num_threads = num; }
     int num_threads() { return _num_threads; }
     bool started() const { return _started; }
     const std::string name() const { return _name; }
 
+private:
+
+    /**
+     * @brief 将忙轮询的设置下发到各个loop
+     */
+    void apply_busy_poll();
+
 private:
 
     // 该类并不拥有main_loop, 是由上层传递而来
@@ -59,6 +106,12 @@ private:
 
     std::atomic<int> _next;    // 下一个连接所属的EventLoop的索引
 
+    PlacementPolicy _placement = PlacementPolicy::kNone;
+
+    // 各个loop的忙轮询时长, 未单独设置的loop使用_default_busy_poll
+    std::chrono::microseconds _default_busy_poll { 0 };
+    std::vector<std::chrono::microseconds> _busy_poll;
+
 };
 
 } // namespace net
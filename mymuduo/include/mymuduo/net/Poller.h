@@ -3,10 +3,10 @@
 
 #include <chrono>
 #include <vector>
-#include <unordered_map>
 
 #include "mymuduo/base/Timestamp.h"
 #include "mymuduo/base/noncopyable.h"
+#include "mymuduo/net/ChannelTable.h"
 
 namespace mymuduo {
 namespace net {
@@ -41,9 +41,7 @@ public:
     virtual ~Poller() = default;
     
 protected:
-    using ChannelMap = std::unordered_map<int, Channel*>;    // key: sockfd
-
-    ChannelMap _channel_map;
+    ChannelTable _channel_table;    // 下标: sockfd
 
 private:
     EventLoop* _owner_loop;
@@ -33,6 +33,7 @@ public:
     void set_reuse_port(bool on);   // 端口重用
     void set_tcp_nodelay(bool on);  // 不启用naggle算法
     void set_keep_alive(bool on);   // 保持连接
+    bool set_zero_copy(bool on);    // 允许 MSG_ZEROCOPY 发送, 返回是否设置成功
 
     int fd() const { return _fd; }
 
@@ -5,6 +5,7 @@
 #include <sys/syscall.h>
 #include <memory>
 #include <atomic>
+#include <deque>
 
 #include "mymuduo/base/Timestamp.h"
 #include "mymuduo/base/noncopyable.h"
@@ -12,6 +13,7 @@
 #include "mymuduo/net/Socket.h"
 #include "mymuduo/net/InetAddress.h"
 #include "mymuduo/net/Buffer.h"
+#include "mymuduo/net/ChainBuffer.h"
 
 
 namespace mymuduo {
@@ -19,6 +21,7 @@ namespace net {
 
 class EventLoop;
 class Channel;
+class IoUringPoller;
 class TcpConnection;
 
 /**
@@ -34,6 +37,18 @@ public:
 
     using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
 
+    // 统计缓冲区内存的计数器, 同一服务器的连接共享一个
+    using BufferGauge = std::shared_ptr<std::atomic<size_t>>;
+
+    // 输入缓冲区连续多少次读取都未被充分使用时收缩, 0表示不按读取次数收缩
+    static constexpr size_t kDefaultShrinkIdleReads = 64;
+
+    // 转发管道期望的容量, 受 /proc/sys/fs/pipe-max-size 限制
+    static constexpr size_t kRelayPipeSize = 256 * 1024;
+
+    // 建议的零拷贝发送阈值, 过小的报文锁定页面和处理完成通知的开销超过拷贝本身
+    static constexpr size_t kDefaultZeroCopyThreshold = 16 * 1024;
+
     enum State {
         kConnecting,        // 连接建立中 (默认状态)
         kConnected,         // 连接已建立 (活跃状态)
@@ -55,9 +70,49 @@ public:
 
     /**
      * @brief 将send交由IO线程执行
+     *  在非IO线程中调用时会拷贝一份message交给IO线程
      */
     void send(const std::string &message);
 
+    /**
+     * @brief 接管报文的所有权, 在非IO线程中调用时将其移动到IO线程的任务中, 不发生拷贝
+     *  适用于在工作线程中构造响应后交给IO线程发送
+     */
+    void send(std::string&& message);
+    void send(Buffer&& buf);
+
+    /**
+     * @brief 共享只读的报文, 如广播给多个连接的同一份数据, IO线程持有引用直到发送完毕
+     */
+    void send(std::shared_ptr<const std::string> message);
+
+    /**
+     * @brief 发送buf中readable区域的全部数据, 发送后buf被清空
+     *  可以先将报文内容写入buf, 再用 Buffer::prepend 原地补上报文头, 整个报文不会被额外拷贝
+     */
+    void send(Buffer* buf);
+
+    /**
+     * @brief 通过 sendfile 发送文件中 [offset, offset + length) 的内容, 数据不经过用户态
+     *  与 send 发送的数据保持先后顺序; 内部会 dup 一份fd, 调用后可以立即关闭fd
+     *  未发送的部分计入高水位, 全部发送后触发写完回调
+     */
+    void send_file(int fd, off_t offset, size_t length);
+
+    /**
+     * @brief 将本连接收到的数据经内核管道用 splice 直接转发给peer, 数据不经过用户态
+     *  两个连接必须属于同一个EventLoop; 转发开始后不再调用本连接的消息回调,
+     *  输入缓冲区中已有的数据会先拷贝发送给peer
+     *  管道写满(peer发送不出去)时暂停读取本连接, peer发送后恢复; 本连接读到EOF时关闭peer的写端
+     *  双向转发需要两端各调用一次, 见 relay()
+     */
+    void relay_to(const TcpConnectionPtr& peer);
+
+    /**
+     * @brief 在两个连接之间建立双向转发
+     */
+    static void relay(const TcpConnectionPtr& a, const TcpConnectionPtr& b);
+
     /**
      * @brief 关闭连接 (写端)
      */
@@ -88,6 +143,67 @@ public:
     void set_close_callback(CloseCallback func) { _close_callback = std::move(func); }
     void set_high_water_mark_callback(HighWaterMarkCallback func) { _high_water_mark_callback = std::move(func); }
     
+    /**
+     * @brief 缓冲区的自适应收缩策略
+     *  输入缓冲区超过初始大小且使用率低于1/4时视为未充分使用;
+     *  连续 idle_reads 次读取都未充分使用, 或者超过 idle_time 没有被充分使用时, 收缩回初始大小;
+     *  输入缓冲区在两次读取之间一直保留, 超过 idle_time 后若为空, 则整块归还内存池
+     *  输出缓冲区的块在数据发送完后立即释放, 收缩时再释放它缓存的空闲块
+     *  参数为0表示不启用对应的条件
+     */
+    void set_buffer_shrink_policy(size_t idle_reads, TimeDuration idle_time) {
+        _shrink_idle_reads = idle_reads;
+        _shrink_idle_time = idle_time;
+    }
+
+    /**
+     * @brief 按照 idle_time 检查缓冲区是否空闲, 空闲则收缩; 只能在loop线程中调用
+     */
+    void shrink_buffers_if_idle(Timestamp now);
+
+    /**
+     * @brief 绑定缓冲区内存的计数器, 需在连接建立前调用
+     */
+    void set_buffer_gauge(BufferGauge gauge) { _buffer_gauge = std::move(gauge); }
+
+    // 输入输出缓冲区占用的内存大小
+    size_t buffer_bytes() const { return _buffer_bytes.load(std::memory_order_relaxed); }
+
+    // 缓冲区已收缩到底(空的输入缓冲区已归还内存), 收缩不会再释放内存; 可在任意线程中调用
+    bool buffers_at_floor() const { return _buffers_at_floor.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 开启 MSG_ZEROCOPY 发送模式, 必须在loop线程中调用(修改socket的选项), threshold为0时关闭
+     *  阈值可以被其它线程中调用的 send 读取; 报文是否零拷贝最终在IO线程发送时按当时的阈值判断
+     *  只有持有报文所有权的 send 重载(右值或shared_ptr)才会使用零拷贝, 且报文不小于threshold,
+     *  报文在内核通过错误队列通知发送完成之前一直由连接持有; 其余报文仍然拷贝发送
+     *  完成式发送时改为: 一次提交的输出缓冲区数据不小于threshold时使用 IORING_OP_SEND_ZC(多段时为 SENDMSG_ZC), 见 set_completion_recv
+     * @return socket不支持 SO_ZEROCOPY 时返回false
+     */
+    bool set_zero_copy(size_t threshold = kDefaultZeroCopyThreshold);
+    size_t zero_copy_threshold() const { return _zerocopy_threshold.load(std::memory_order_relaxed); }
+
+    // 等待内核完成通知的零拷贝报文个数
+    size_t zero_copy_pending() const { return _zerocopy_pending.size(); }
+
+    // 被内核退化为拷贝发送的零拷贝报文个数(如回环地址)
+    size_t zero_copy_copied() const { return _zerocopy_copied; }
+
+    /**
+     * @brief 开启完成式接收, 需在连接建立前调用; 只有loop使用io_uring时才生效, 否则仍按就绪事件读取
+     *  连接保持一个 multishot recv 请求, 内核直接将数据写入loop共享的缓冲区环, 读回调时不再调用readv;
+     *  空闲的连接不占用接收内存. 发送同时改为异步请求, 每次将输出缓冲区链首起的多个块(与writev相同)作为一个
+     *  IORING_OP_SENDMSG(或 SENDMSG_ZC, 只有一个块时为 SEND/SEND_ZC) 请求提交, 这些块在内核不再读取之前保持锁定;
+     *  请求完成后由写回调丢弃已发送的部分并提交剩余的数据, 见 IoUringPoller::submit_send
+     */
+    void set_completion_recv(bool on) { _completion_recv = on; }
+
+    // 完成式接收是否已经生效
+    bool completion_recv() const { return _completion_recv && _uring != nullptr; }
+
+    // 完成式发送是否已经生效
+    bool completion_send() const { return _uring_send != nullptr; }
+
     void set_high_water_mark(size_t high_water_mark) { _high_water_mark = high_water_mark; }
     const size_t high_water_mark() const { return _high_water_mark; }
     int fd() const { return _sock->fd(); }
@@ -106,12 +222,97 @@ private:
      */
     void handle_read_ET(Timestamp receieveTime);
     void handle_read_LT(Timestamp receieveTime);
+    void handle_read_completion(Timestamp receieveTime);
     void handle_write();
     void handle_close();
     void handle_error();
 
 
-    void send_in_loop(const void* data, size_t len);
+    /**
+     * @brief 每次读取后更新输入缓冲区的使用情况, 按读取次数收缩
+     */
+    void update_buffer_usage(Timestamp receive_time);
+    void shrink_buffers();
+
+    /**
+     * @brief 将缓冲区大小的变化同步到计数器中
+     */
+    void sync_buffer_gauge();
+
+    /**
+     * @param holder 报文的所有者, 不为空时允许零拷贝发送, 并持有到内核发送完成
+     */
+    void send_in_loop(const void* data, size_t len, std::shared_ptr<const void> holder = nullptr);
+    void send_file_in_loop(int fd, off_t offset, size_t length);
+
+    /**
+     * @brief holder持有[data, data + len), 将其交给IO线程发送
+     */
+    void send_owned(std::shared_ptr<const void> holder, const void* data, size_t len);
+
+    /**
+     * @brief 按顺序将输出缓冲区和待发送的文件写入socket, 直到全部写完或socket写满
+     * @return 出错时返回false, 错误码保存在save_errno中
+     */
+    bool write_output(int* save_errno);
+
+    /**
+     * @brief 发送输出缓冲区链首最多max_len字节; 完成式发送时只提交请求, 已发送的部分在请求完成后由 finish_send 丢弃
+     * @return 本次已经发送的字节数, 出错时返回-1, 错误码保存在save_errno中
+     */
+    ssize_t write_chain(int* save_errno, size_t max_len = SIZE_MAX);
+
+    /**
+     * @brief 取出完成式发送的结果, 从输出缓冲区中丢弃已发送的部分; 请求还未完成时不做任何事
+     * @return 出错时返回false, 错误码保存在save_errno中
+     */
+    bool finish_send(int* save_errno);
+
+    // 输出缓冲区和待发送文件中还未发送的字节数
+    size_t pending_output() const {
+        return _output_buffer.readable() + _output_file_bytes + (_relay_in ? _relay_in->bytes : 0);
+    }
+
+    void close_output_files();
+
+    /**
+     * @brief 从socket的错误队列中取出零拷贝的完成通知, 释放对应的报文
+     * @return 是否取到了完成通知
+     */
+    bool handle_zero_copy_completions();
+
+    /**
+     * @brief 转发模式下的读事件, 将socket中的数据splice进管道
+     */
+    void handle_relay_read();
+    void relay_to_in_loop(const TcpConnectionPtr& peer);
+
+    /**
+     * @brief 将完成式接收停止前内核已经收到的数据拷贝发送给peer
+     * @return recv请求已经结束, 之后的数据都留在socket中, 可以splice时返回true
+     */
+    bool relay_received(const TcpConnectionPtr& peer);
+
+    /**
+     * @brief 管道中有新数据时由数据源调用, 尝试将其发送出去
+     */
+    void flush_relay();
+
+    /**
+     * @brief 管道有空余时由转发目标调用, 恢复读取
+     */
+    void resume_relay_read();
+
+    /**
+     * @brief 取出已收到的数据后退回到按就绪事件读取
+     *  内核确认取消recv请求之前收到的数据由 relay_received 取出, 在此之前保留_uring
+     */
+    void stop_completion_recv();
+    // MARK: 持有所有权的 send 重载在调用者的线程中判断是否零拷贝, 阈值由loop线程修改, 须原子地读取
+    bool use_zero_copy(size_t len) const {
+        const size_t threshold = _zerocopy_threshold.load(std::memory_order_relaxed);
+        return threshold > 0 && len >= threshold;
+    }
     void shutdown_in_loop();
     void force_close_in_loop();
 
@@ -143,7 +344,59 @@ private:
      */
 
         Buffer _input_buffer;
-        Buffer _output_buffer;
+        ChainBuffer _output_buffer;     // 链式输出缓冲, 由writev集中发送
+
+        // 待发送的文件, 与输出缓冲区中的数据交错排列
+        struct OutputFile {
+            int fd;
+            off_t offset;
+            size_t remaining;
+            size_t preceding;           // 输出缓冲区中须在该文件之前发送的字节数
+        };
+        std::deque<OutputFile> _output_files;
+        size_t _output_file_bytes;      // 所有待发送文件剩余的字节数
+
+        // 转发数据的内核管道, 由数据源和转发目标共享
+        struct RelayPipe : noncopyable {
+            int fds[2] = { -1, -1 };
+            size_t bytes = 0;           // 管道中待发送的字节数
+            size_t capacity = 0;
+
+            ~RelayPipe() {
+                if(fds[0] >= 0) ::close(fds[0]);
+                if(fds[1] >= 0) ::close(fds[1]);
+            }
+        };
+        std::shared_ptr<RelayPipe> _relay_out;      // 本连接读到的数据写入该管道
+        std::weak_ptr<TcpConnection> _relay_peer;   // 转发目标
+        std::shared_ptr<RelayPipe> _relay_in;       // 本连接从该管道取数据发送
+        std::weak_ptr<TcpConnection> _relay_source; // 数据源
+        bool _relay_paused;                         // 因管道写满而暂停读取
+
+        // 完成式接收, 生效(或停止后还有数据未取出)时指向loop的poller
+        bool _completion_recv;
+        IoUringPoller* _uring;
+
+        // 完成式发送, 生效时指向loop的poller; 输出缓冲区链首已提交给内核还未完成的字节数
+        IoUringPoller* _uring_send;
+        size_t _sending;
+
+        // 零拷贝发送
+        std::atomic<size_t> _zerocopy_threshold;
+        uint32_t _zerocopy_next_id;     // 下一次零拷贝发送的编号, 与内核的计数保持一致
+        std::deque<std::pair<uint32_t, std::shared_ptr<const void>>> _zerocopy_pending;
+        size_t _zerocopy_copied;
+
+        // 自适应收缩策略
+        size_t _shrink_idle_reads;
+        TimeDuration _shrink_idle_time;
+        size_t _underused_reads;        // 输入缓冲区连续未充分使用的读取次数
+        Timestamp _last_busy;           // 输入缓冲区最近一次被充分使用的时间
+
+        // 缓冲区内存的统计
+        BufferGauge _buffer_gauge;
+        std::atomic<size_t> _buffer_bytes;
+        std::atomic<bool> _buffers_at_floor;    // 与 _buffer_bytes 一同更新, 供其它线程判断是否值得收缩
 
     /**
      * 回调函数
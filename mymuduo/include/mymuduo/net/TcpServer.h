@@ -9,6 +9,7 @@
 
 #include "mymuduo/base/noncopyable.h"
 #include "mymuduo/net/callbacks.h"
+#include "mymuduo/net/Codec.h"
 #include "mymuduo/net/EventLoop.h"
 #include "mymuduo/net/EventLoopThread.h"
 #include "mymuduo/net/EventLoopThreadPool.h"
@@ -56,11 +57,54 @@ public:
         _loop_threads->set_thread_num(num_threads);
     }
 
+    /**
+     * @brief 从EventLoop的忙轮询时长, 见 EventLoopThreadPool::set_busy_poll
+     */
+    void set_busy_poll(std::chrono::microseconds budget) {
+        _loop_threads->set_busy_poll(budget);
+    }
+
+    /**
+     * @brief 从EventLoop线程的放置策略, 见 EventLoopThreadPool::set_placement; 需在启动前调用
+     */
+    void set_placement(PlacementPolicy policy) {
+        _loop_threads->set_placement(policy);
+    }
+
     void set_connection_callback(ConnectionCallback func) { _connection_callback = std::move(func); }
     void set_message_callback(MessageCallback func) { _message_callback = std::move(func); }
     void set_write_complete_callback(WriteCompleteCallback func) { _write_complete_callback = std::move(func); }
+
+    /**
+     * @brief 为服务器绑定一个编解码器, 每收到一个完整的报文就调用一次func
+     *        会替换掉 message_callback; 需在启动前调用
+     */
+    template <codec::FramingCodec Codec>
+    void set_codec(Codec c, FrameCallback func) {
+        _message_callback = codec::make_message_callback(std::move(c), std::move(func));
+    }
+
     void set_thread_init_callback(ThreadInitCallback func) { _thread_init_callback = std::move(func); }
 
+    /**
+     * @brief 连接缓冲区的自适应收缩策略, 见 TcpConnection::set_buffer_shrink_policy
+     *        idle_time 不为0时, 主loop每隔 idle_time 检查一次所有连接; 需在启动前调用
+     */
+    void set_buffer_shrink_policy(size_t idle_reads, TimeDuration idle_time) {
+        _shrink_idle_reads = idle_reads;
+        _shrink_idle_time = idle_time;
+    }
+
+    /**
+     * @brief 新连接开启完成式接收, 见 TcpConnection::set_completion_recv; 需在启动前调用
+     */
+    void set_completion_recv(bool on) { _completion_recv = on; }
+
+    /**
+     * @brief 所有连接的输入输出缓冲区占用的内存总量
+     */
+    size_t buffer_bytes() const { return _buffer_gauge->load(std::memory_order_relaxed); }
+
     const InetAddress& listen_addr() const { return _acceptor->listen_addr(); }    
 
 private:
@@ -70,6 +114,11 @@ private:
     void remove_connection(const TcpConnectionPtr &conn);
     void remove_connection_in_loop(const TcpConnectionPtr &conn);
 
+    /**
+     * @brief 定时让各个连接在自己的loop中检查并收缩空闲的缓冲区
+     */
+    void shrink_idle_buffers();
+
 private:
     const std::string _name;      // 服务器名称
     const std::string _ip_port;   // 服务器地址信息
@@ -91,6 +140,13 @@ private:
     std::atomic<bool> _stopping;
 
     bool _is_ET;
+    bool _completion_recv;
+
+    // 缓冲区的收缩策略与内存统计
+    size_t _shrink_idle_reads;
+    TimeDuration _shrink_idle_time;
+    TimerId _shrink_timer;
+    TcpConnection::BufferGauge _buffer_gauge;
 
     ConnectionCallback _connection_callback;
     MessageCallback _message_callback;
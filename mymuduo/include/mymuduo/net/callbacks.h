@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <memory>
+#include <string_view>
 
 #include "mymuduo/base/Timestamp.h"
 
@@ -21,6 +22,7 @@ using ConnectionCallback = std::function<void(const TcpConnectionPtr&)>;
 using CloseCallback = std::function<void(const TcpConnectionPtr&)>;
 using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
 using MessageCallback = std::function<void(const TcpConnectionPtr&, Buffer*, Timestamp)>;
+using FrameCallback = std::function<void(const TcpConnectionPtr&, std::string_view, Timestamp)>;
 
 using TimerCallback = std::function<void()>;
 using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
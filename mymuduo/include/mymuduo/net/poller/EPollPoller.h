@@ -1,11 +1,16 @@
 #ifndef MYMUDUO_NET_TIMESTAMP_H
 #define MYMUDUO_NET_TIMESTAMP_H
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <cstring>
 #include <sys/epoll.h>
 
+#include "mymuduo/base/Histogram.h"
 #include "mymuduo/net/Poller.h"
 
 namespace mymuduo {
@@ -14,6 +19,16 @@ namespace net {
 class Channel;
 class EventLoop;
 
+/**
+ * @brief 基于epoll的Poller
+ *  update_channel 不直接调用epoll_ctl, 只将Channel标记为脏, 在下一次 epoll_wait 之前按
+ *  Channel当前的事件与内核中已注册的事件的差值统一提交; 同一轮内相互抵消的修改(如发送在本轮
+ *  就完成时的开关EPOLLOUT)不产生系统调用
+ *  取消所有事件与 remove_channel 仍然立即调用epoll_ctl, 因为调用者随后就可能关闭fd
+ *
+ *  接收事件的数组按就绪的fd数自适应: 一次 epoll_wait 填满时加倍(不超过上限), 连续多轮占用不到
+ *  四分之一时减半(不低于初始大小)
+ */
 class EPollPoller : public Poller {
 public:
     using ChannelList = std::vector<Channel*>;
@@ -28,31 +43,82 @@ public:
     Timestamp poll(ChannelList *activeChannels, std::chrono::system_clock::duration timeout) override;
 
     /**
-     * @brief 调用epoll_ctl, 修改ch监听事件
+     * @brief 记录ch监听事件的修改, 在下一次poll时提交给内核
      */
     void update_channel(Channel *ch) override;
 
     /**
-     * @brief 取消监听ch的事件
+     * @brief 立即取消监听ch的事件, 并丢弃ch还未提交的修改
      */
     void remove_channel(Channel *ch) override;
 
+    // 调用epoll_ctl的次数
+    std::size_t ctl_calls() const { return _ctl_calls; }
+
+    /**
+     * @brief 设置接收事件数组的上限, 可以在任意线程中调用, 下一轮poll生效
+     *  上限越大, 就绪的fd很多时需要的 epoll_wait 轮数越少, 但空闲时占用的内存越多
+     */
+    void set_max_events(std::size_t max_events) {
+        _max_events.store(std::max(max_events, kInitEvents), std::memory_order_relaxed);
+    }
+    std::size_t max_events() const { return _max_events.load(std::memory_order_relaxed); }
+
+    // 接收事件数组当前的大小, 只能在loop线程中调用
+    std::size_t event_capacity() const { return _events_arr.size(); }
+
+    /**
+     * @brief 每次poll返回的就绪事件数的分布, 可以在任意线程中调用, 用于调整上限
+     */
+    Histogram::Snapshot ready_events() const { return _ready_events.snapshot(); }
+
+    // 填满接收事件数组的poll次数, 达到上限后仍然增长说明上限偏小
+    uint64_t saturated_polls() const { return _saturated_polls.load(std::memory_order_relaxed); }
+
+    static constexpr std::size_t kInitEvents = 16;          // 接收事件数组的初始大小, 也是下限
+    static constexpr std::size_t kDefaultMaxEvents = 4096;  // 默认的上限
+    static constexpr unsigned kShrinkAfter = 128;           // 连续多少轮占用不到四分之一时减半
+
 private:
     void fill_active_channels(int numEvents, ChannelList *activeChannels) const;
-    
+
     /**
-     * @brief update_channel与remove_channle的底层操作
+     * @brief 根据本轮的就绪事件数调整接收事件数组的大小
      */
-    void update(int op, Channel *ch);
+    void adjust_events(int numEvents);
+
+    /**
+     * @brief 将本轮标记过的Channel的净修改提交给内核
+     */
+    void flush_changes();
+
+    /**
+     * @brief flush_changes与remove_channle的底层操作
+     * @return epoll_ctl是否成功
+     */
+    bool update(int op, Channel *ch, uint32_t events);
 
 private:
+    struct Interest {
+        uint32_t registered = 0;    // 已注册到内核的事件, 0表示不在epoll中
+        bool dirty = false;         // 已加入 _dirty
+    };
+
     using EventList = std::vector<epoll_event>;
 
-    static const int _max_events = 16;    // 发生事件的最大数量
-    
     int _epoll_fd = -1;       // epollfd
 
     EventList _events_arr;    // 发生事件的合集
+    std::atomic<std::size_t> _max_events { kDefaultMaxEvents };
+    unsigned _low_polls = 0;  // 连续占用不到四分之一的轮数
+
+    Histogram _ready_events;
+    std::atomic<uint64_t> _saturated_polls { 0 };
+
+    std::vector<Interest> _interests;               // 下标: fd, 与 _channel_table 一起扩容
+    std::vector<int> _dirty;                        // 本轮修改过监听事件的fd
+
+    std::size_t _ctl_calls = 0;
 };
 
 } // namespace net
@@ -0,0 +1,323 @@
+#ifndef MYMUDUO_NET_POLLER_IOURINGPOLLER_H
+#define MYMUDUO_NET_POLLER_IOURINGPOLLER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unordered_map>
+#include <vector>
+#include <linux/io_uring.h>
+
+#include "mymuduo/net/Poller.h"
+
+namespace mymuduo {
+namespace net {
+
+class Buffer;
+class Channel;
+class EventLoop;
+
+/**
+ * @brief 基于io_uring的Poller, 直接使用系统调用, 不依赖liburing
+ *  每个Channel对应一个 IORING_OP_POLL_ADD 请求:
+ *   - LT的Channel使用单次poll, 完成后在下一轮重新提交, 提交时内核会立即检查就绪状态, 语义与LT相同
+ *   - ET的Channel使用多次触发(multishot)的poll, 只在状态变化时产生完成事件, 语义与ET相同
+ *
+ *  update_channel 只标记Channel, 在下一次 poll 时统一生成SQE, 与等待事件合并为一次 io_uring_enter;
+ *  取消监听的事件(如频繁开关的EPOLLOUT)时不修改请求, 多余的事件在完成时过滤, 请求完成后再按新的事件提交
+ *
+ *  开启完成式接收的Channel, 读事件改为一个 multishot 的 IORING_OP_RECV 请求,
+ *  数据由内核直接写入本loop共享的缓冲区池(通过 IORING_REGISTER_PBUF_RING 注册的缓冲区环提供);
+ *  开启完成式发送的Channel, 数据通过 IORING_OP_SEND(或 SEND_ZC) 请求发送, 多段内存合并为一个 IORING_OP_SENDMSG(或 SENDMSG_ZC) 请求;
+ *  请求进行中时不监听写事件, 完成时通知写事件
+ */
+class IoUringPoller : public Poller {
+public:
+    using ChannelList = std::vector<Channel*>;
+
+    // 提交队列的大小
+    static constexpr unsigned kEntries = 256;
+
+    // 完成式接收共享的缓冲区个数与每个缓冲区的大小, 缓冲区环的大小须为2的幂
+    static constexpr unsigned kRecvBuffers = 1024;
+    static constexpr std::size_t kRecvBufferSize = 4096;
+    static_assert((kRecvBuffers & (kRecvBuffers - 1)) == 0 && kRecvBuffers <= 32768);
+
+public:
+    IoUringPoller(EventLoop *loop);
+    ~IoUringPoller() override;
+
+    /**
+     * @brief 内核是否支持: io_uring_setup 成功且支持 EXT_ARG, 32位poll事件(multishot poll)与NODROP
+     */
+    bool valid() const { return _ring_fd >= 0; }
+
+    Timestamp poll(ChannelList *activeChannels, std::chrono::system_clock::duration timeout) override;
+    void update_channel(Channel *ch) override;
+    void remove_channel(Channel *ch) override;
+
+    /**
+     * @brief 开启或关闭ch的完成式接收, 第一次开启时创建缓冲区池
+     *  内核只在数据到达时才从缓冲区池中取出缓冲区, 空闲的连接不占用接收内存;
+     *  开启后ch的读事件表示已经收到了数据(或对端关闭), 用 take_received 取出
+     *  关闭时取消recv请求, 内核确认取消之前收到的数据仍然保存, 照常通知读事件, 由 take_received 取出;
+     *  在此之前不监听读就绪事件, 以免按就绪事件读到的数据排在前面, 见 recv_pending
+     * @return 内核不支持提供缓冲区或multishot recv时返回false
+     */
+    bool set_completion_recv(Channel *ch, bool on);
+
+    /**
+     * @brief 将ch已经收到的数据追加到buf中, 缓冲区随即归还给内核, 语义与read相同:
+     * @return 追加的字节数; 对端已关闭且数据已取完时返回0;
+     *         出错时返回-1并设置errno, 没有数据时errno为EAGAIN
+     */
+    ssize_t take_received(Channel *ch, Buffer *buf);
+
+    /**
+     * @brief ch是否还有没有结束的recv请求(包括已取消但内核还未确认的), 之后可能还会收到数据
+     */
+    bool recv_pending(Channel *ch) const;
+
+    /**
+     * @brief 开启或关闭ch的完成式发送, 之后用 submit_send 发送数据
+     * @return 内核不支持 IORING_OP_SEND_ZC 时返回false
+     */
+    bool set_completion_send(Channel *ch, bool on);
+
+    /**
+     * @brief 提交一个发送[data, data + len)的请求, zero_copy为true时使用 IORING_OP_SEND_ZC; 每个Channel同时只有一个发送请求
+     *  holder持有这段内存, 直到内核不再读取它(请求的完成事件, 零拷贝时为之后的完成通知)才释放, 与ch是否已移除无关
+     *  请求完成时通知ch的写事件, 用 take_sent 取出结果
+     * @return 没有开启完成式发送, 或者已有未取出结果的发送请求时返回false
+     */
+    bool submit_send(Channel *ch, const void *data, std::size_t len, bool zero_copy, std::shared_ptr<const void> holder) {
+        struct iovec iov { const_cast<void*>(data), len };
+        return submit_send(ch, &iov, 1, zero_copy, std::move(holder));
+    }
+
+    /**
+     * @brief 用一个请求依次发送iov中的多段内存, 多于一段时使用 IORING_OP_SENDMSG(或 SENDMSG_ZC), 其余与上面相同
+     *  iov在返回后即可释放, 请求使用的是它的副本
+     */
+    bool submit_send(Channel *ch, const struct iovec *iov, int iov_count, bool zero_copy, std::shared_ptr<const void> holder);
+
+    /**
+     * @brief 取出ch的发送请求的结果, 语义与write相同:
+     * @return 发送的字节数; 出错时返回-1并设置errno, 请求还未完成时errno为EAGAIN
+     */
+    ssize_t take_sent(Channel *ch);
+
+    // 提交的发送请求个数, 其中零拷贝的个数
+    std::size_t send_requests() const { return _send_requests; }
+    std::size_t zero_copy_requests() const { return _zero_copy_requests; }
+
+    // 内核可能还在读取的发送内存的个数(零拷贝的发送在完成通知之前都计入)
+    std::size_t inflight_sends() const { return _sends.size(); }
+
+    // 调用io_uring_enter的次数
+    std::size_t enter_calls() const { return _enter_calls; }
+
+    // 缓冲区池中可供内核使用(包括即将归还)的缓冲区个数
+    unsigned free_recv_buffers() const { return _recv_buffers_free; }
+
+private:
+    struct PollState {
+        Channel* ch = nullptr;
+        uint32_t seq = 0;               // 当前poll请求的序号, 用于识别已过期请求的完成事件
+        uint32_t armed_events = 0;      // 已提交给内核的事件, 0表示没有进行中的请求
+        bool multishot = false;
+        bool dirty = false;             // 需要在下一轮poll时重新提交
+        bool active = false;            // Channel处于kAdded状态; 否则不再访问ch, 它可能已被析构
+        bool pending = false;           // ch还未加入, 状态由它在加入前设置(完成模式), 加入时保留
+        uint64_t round = 0;             // 最近一次加入活跃列表的轮次, 防止重复加入
+
+        // 完成式接收
+        bool recv_mode = false;
+        bool recv_armed = false;        // 有进行中的recv请求, 直到收到不带MORE标记的完成事件
+        bool recv_cancelled = false;    // 已经提交了取消, 等待内核确认
+        bool recv_eof = false;
+        bool ready = false;             // 已加入 _ready
+        int recv_error = 0;
+        uint32_t recv_seq = 0;
+        std::vector<std::pair<uint16_t, uint32_t>> received;   // 已收到还未取出的数据: 缓冲区编号, 长度
+
+        // 完成式发送
+        bool send_mode = false;
+        bool send_armed = false;        // 有进行中的发送请求, 直到收到它的(第一个)完成事件
+        bool send_done = false;         // 已完成还未取出结果
+        int send_result = 0;
+        uint32_t send_seq = 0;
+    };
+
+    // 进行中的发送请求, 内核在请求的最后一个完成事件之前都可能读取msg, iov以及它们指向的内存
+    struct SendRequest {
+        struct msghdr msg {};
+        std::vector<struct iovec> iov;
+        std::shared_ptr<const void> holder;
+    };
+
+    bool setup();
+    void teardown();
+
+    /**
+     * @brief 取消所有进行中的请求, 等待发送与recv请求(零拷贝时包括完成通知)全部结束, 最多等待 kCancelTimeout
+     * @return 内核是否已不再访问_sends持有的内存与缓冲区池
+     */
+    bool cancel_all();
+
+    /**
+     * @brief fd对应的状态, 没有Channel(已移除或从未设置)时返回空
+     */
+    PollState* find_state(int fd) {
+        return fd >= 0 && static_cast<std::size_t>(fd) < _states.size() && _states[fd].ch ? &_states[fd] : nullptr;
+    }
+    const PollState* find_state(int fd) const {
+        return const_cast<IoUringPoller*>(this)->find_state(fd);
+    }
+
+    /**
+     * @brief 取ch的状态, 必要时扩容; 还未加入的ch遇到同一个fd上残留的旧状态时先清除
+     */
+    PollState& prepare_state(Channel *ch);
+
+    /**
+     * @brief 归还已收到的缓冲区, 清除所有状态(包括ch), 之后的完成事件都被丢弃
+     */
+    void reset_state(PollState& state);
+
+    /**
+     * @brief 取一个空闲的SQE, 提交队列已满时先提交, 直到内核取走SQE为止
+     * @return 内核无法接受新的请求时返回空, 调用者不修改状态, 之后再重试
+     */
+    io_uring_sqe* get_sqe();
+
+    /**
+     * @brief 将完成队列中的事件移到 _backlog 中, 为内核腾出空间
+     * @return 移出的事件个数
+     */
+    std::size_t stash_cqes();
+
+    // 取不到SQE时返回false
+    bool arm(int fd, PollState& state, uint32_t events, bool multishot);
+    bool arm_recv(int fd, PollState& state);
+    bool cancel(uint64_t user_data);
+    uint32_t next_seq() { return ++_next_seq & ~(kRecvSeqBit | kSendSeqBit); }
+    void mark_dirty(int fd, PollState& state);
+
+    /**
+     * @brief 将本轮标记过的Channel转换为SQE
+     */
+    void flush_changes();
+
+    /**
+     * @brief 提交所有SQE; get_events为true时收割完成事件, wait为true时等待至少一个完成事件
+     * @return io_uring_enter的返回值, 失败时为-errno
+     */
+    int enter(bool get_events, bool wait, std::chrono::system_clock::duration timeout);
+
+    void reap(ChannelList *activeChannels);
+    void on_cqe(const io_uring_cqe& cqe, ChannelList *activeChannels);
+
+    void on_recv_completion(int fd, PollState& state, const io_uring_cqe& cqe);
+
+    /**
+     * @brief 将收到了数据且正在监听读事件的Channel加入活跃列表(activeChannels可以为空)
+     * @return 是否有这样的Channel
+     */
+    bool collect_ready(ChannelList *activeChannels);
+
+    static bool has_received(const PollState& state) {
+        return !state.received.empty() || state.recv_eof || state.recv_error != 0;
+    }
+
+    /**
+     * @brief 内核是否支持完成式接收与发送需要的请求, 只探测一次
+     */
+    bool probe_completion_ops();
+    bool setup_recv_pool();
+
+    /**
+     * @brief 将缓冲区写入缓冲区环, 在下一次提交前统一推进环的尾部, 不需要SQE
+     */
+    void recycle_buffer(uint16_t bid);
+    void recycle_received(PollState& state);
+    void flush_recycled();
+    char* buffer_addr(uint16_t bid) const { return _recv_pool + static_cast<std::size_t>(bid) * kRecvBufferSize; }
+
+    static uint64_t make_tag(int fd, uint32_t seq) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(fd)) << 32) | seq;
+    }
+
+private:
+    // 取消请求(ASYNC_CANCEL)自身的完成事件使用该标记, 直接丢弃
+    static constexpr uint64_t kCancelTag = UINT64_MAX;
+
+    // recv与发送请求的序号分别带有这两个标记, 与poll请求区分
+    static constexpr uint32_t kRecvSeqBit = 1u << 31;
+    static constexpr uint32_t kSendSeqBit = 1u << 30;
+
+    // 缓冲区池的组号
+    static constexpr uint16_t kRecvGroup = 0;
+
+    // 析构时等待请求取消的最长时间
+    static constexpr std::chrono::seconds kCancelTimeout { 1 };
+
+    int _ring_fd = -1;
+
+    // 映射的内存
+    void* _sq_ring = nullptr;
+    void* _cq_ring = nullptr;
+    std::size_t _sq_ring_size = 0;
+    std::size_t _cq_ring_size = 0;
+    io_uring_sqe* _sqes = nullptr;
+    std::size_t _sqes_size = 0;
+
+    // 提交队列
+    unsigned* _sq_head = nullptr;
+    unsigned* _sq_tail = nullptr;
+    unsigned* _sq_array = nullptr;
+    unsigned _sq_mask = 0;
+    unsigned _sq_entries = 0;
+    unsigned _sq_local_tail = 0;        // 已填写但还未公布给内核的SQE的尾部
+
+    // 完成队列
+    unsigned* _cq_head = nullptr;
+    unsigned* _cq_tail = nullptr;
+    unsigned _cq_mask = 0;
+    io_uring_cqe* _cqes = nullptr;
+
+    // 缓冲区池的内存与缓冲区环, 第一次开启完成式接收时创建
+    char* _recv_pool = nullptr;
+    io_uring_buf_ring* _buf_ring = nullptr;
+    uint16_t _buf_ring_tail = 0;        // 已写入但还未公布给内核的缓冲区环的尾部
+    unsigned _recv_buffers_free = 0;
+    bool _recv_pool_failed = false;
+    int _completion_ops = -1;           // probe_completion_ops 的结果, -1表示还未探测
+    bool _sendmsg_zero_copy = false;    // 是否支持 IORING_OP_SENDMSG_ZC, 不支持时多段的零拷贝发送改为拷贝
+
+    // 内核可能还在读取的发送请求, key: 发送请求的user_data; 节点的地址不变, msg可以直接交给内核
+    std::unordered_map<uint64_t, SendRequest> _sends;
+    std::size_t _send_requests = 0;
+    std::size_t _zero_copy_requests = 0;
+    std::size_t _recv_requests = 0;     // 还未结束的recv请求(包括已取消但内核还未确认的)
+
+    std::vector<PollState> _states;     // 下标: fd, 与 _channel_table 一起扩容
+    std::vector<int> _dirty;
+    std::vector<int> _flushing;     // flush_changes 正在处理的 _dirty, 交换后复用内存
+    std::vector<io_uring_cqe> _backlog;     // 从完成队列中移出还未处理的完成事件
+    std::vector<int> _ready;        // 有未取出的数据的fd
+    std::vector<int> _starved;      // 因缓冲区耗尽而等待重新提交recv的fd
+
+    uint32_t _next_seq = 0;
+    uint64_t _round = 0;
+    std::size_t _enter_calls = 0;
+};
+
+} // namespace net
+} // namespace mymuduo
+
+#endif // MYMUDUO_NET_POLLER_IOURINGPOLLER_H
@@ -0,0 +1,47 @@
+#ifndef MYMUDUO_NET_POLLER_POLLPOLLER_H
+#define MYMUDUO_NET_POLLER_POLLPOLLER_H
+
+#include <chrono>
+#include <vector>
+#include <poll.h>
+
+#include "mymuduo/net/Poller.h"
+
+namespace mymuduo {
+namespace net {
+
+class Channel;
+class EventLoop;
+
+/**
+ * @brief 基于poll(2)的Poller, 适合只监听少量fd的loop(如客户端, 定时器线程)
+ *  没有epoll实例, 修改监听事件只是修改用户态数组, 不需要epoll_ctl;
+ *  pollfd紧凑排列, Channel记录自己的下标, 删除时与末尾交换, 均为O(1)
+ *  poll只支持LT, Channel设置的EPOLLET被忽略
+ */
+class PollPoller : public Poller {
+public:
+    using ChannelList = std::vector<Channel*>;
+
+public:
+    PollPoller(EventLoop *loop);
+    ~PollPoller() override = default;
+
+    Timestamp poll(ChannelList *activeChannels, std::chrono::system_clock::duration timeout) override;
+    void update_channel(Channel *ch) override;
+    void remove_channel(Channel *ch) override;
+
+private:
+    void fill_active_channels(int numEvents, ChannelList *activeChannels) const;
+
+    static short to_poll_events(Channel *ch);
+
+private:
+    std::vector<pollfd> _pollfds;
+    std::vector<Channel*> _channels;    // 与 _pollfds 一一对应
+};
+
+} // namespace net
+} // namespace mymuduo
+
+#endif // MYMUDUO_NET_POLLER_POLLPOLLER_H
@@ -0,0 +1,181 @@
+#include "mymuduo/base/CpuTopology.h"
+#include "mymuduo/base/Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <tuple>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+
+using namespace mymuduo;
+
+namespace {
+
+constexpr const char* kSysfsRoot = "/sys/devices/system";
+
+// 读取文件的第一行, 文件不存在时返回空串
+std::string read_line(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+int read_int(const std::string& path, int fallback) {
+    std::string line = read_line(path);
+    if(line.empty()) {
+        return fallback;
+    }
+    try {
+        return std::stoi(line);
+    }
+    catch(...) {
+        return fallback;
+    }
+}
+
+} // namespace
+
+std::vector<int> CpuTopology::parse_cpu_list(const std::string& list)
+{
+    std::vector<int> cpus;
+
+    std::size_t pos = 0;
+    while(pos < list.size()) {
+        std::size_t end = list.find(',', pos);
+        if(end == std::string::npos) {
+            end = list.size();
+        }
+
+        const std::string item = list.substr(pos, end - pos);
+        pos = end + 1;
+
+        int lo = 0, hi = 0;
+        if(std::sscanf(item.c_str(), "%d-%d", &lo, &hi) == 2) {
+            for(int cpu = lo; cpu <= hi; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+        else if(std::sscanf(item.c_str(), "%d", &lo) == 1) {
+            cpus.push_back(lo);
+        }
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+CpuTopology CpuTopology::from_sysfs(const std::string& root)
+{
+    namespace fs = std::filesystem;
+
+    CpuTopology topo;
+    const std::string cpu_dir = root + "/cpu";
+
+    std::vector<int> online = parse_cpu_list(read_line(cpu_dir + "/online"));
+    const std::vector<int> isolated = parse_cpu_list(read_line(cpu_dir + "/isolated"));
+
+    // 每个CPU所属的NUMA节点, 没有node目录时都视为节点0
+    std::vector<std::pair<int, int>> cpu_node;
+    std::error_code ec;
+    for(const auto& entry : fs::directory_iterator(root + "/node", ec)) {
+        const std::string name = entry.path().filename().string();
+        int node = 0;
+        if(name.rfind("node", 0) != 0 || std::sscanf(name.c_str() + 4, "%d", &node) != 1) {
+            continue;
+        }
+        for(int cpu : parse_cpu_list(read_line(entry.path().string() + "/cpulist"))) {
+            cpu_node.emplace_back(cpu, node);
+        }
+    }
+
+    for(int id : online) {
+        if(std::binary_search(isolated.begin(), isolated.end(), id)) {
+            continue;
+        }
+
+        Cpu cpu;
+        cpu.id = id;
+
+        const std::string topo_dir = cpu_dir + "/cpu" + std::to_string(id) + "/topology";
+        cpu.core = read_int(topo_dir + "/core_id", id);
+        cpu.package = read_int(topo_dir + "/physical_package_id", 0);
+
+        auto it = std::find_if(cpu_node.begin(), cpu_node.end(),
+                               [id](const auto& p) { return p.first == id; });
+        cpu.node = it != cpu_node.end() ? it->second : 0;
+
+        topo._cpus.push_back(cpu);
+    }
+
+    std::sort(topo._cpus.begin(), topo._cpus.end(), [](const Cpu& a, const Cpu& b) {
+        return std::tie(a.node, a.package, a.core, a.id) < std::tie(b.node, b.package, b.core, b.id);
+    });
+    return topo;
+}
+
+CpuTopology CpuTopology::detect()
+{
+    CpuTopology topo = from_sysfs(kSysfsRoot);
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if(::sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        std::erase_if(topo._cpus, [&allowed](const Cpu& cpu) {
+            return cpu.id >= CPU_SETSIZE || !CPU_ISSET(cpu.id, &allowed);
+        });
+    }
+    return topo;
+}
+
+int CpuTopology::num_nodes() const
+{
+    int max_node = 0;
+    for(const Cpu& cpu : _cpus) {
+        max_node = std::max(max_node, cpu.node);
+    }
+    return max_node + 1;
+}
+
+bool CpuTopology::pin_current_thread(const std::vector<int>& cpus)
+{
+    if(cpus.empty()) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : cpus) {
+        if(cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    if(::sched_setaffinity(0, sizeof(set), &set) < 0) {
+        LOG_WARN("sched_setaffinity failed, errno = {} {}.", errno, strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool CpuTopology::prefer_memory_node(int node)
+{
+    if(node < 0 || node >= static_cast<int>(sizeof(unsigned long) * 8)) {
+        return false;
+    }
+
+    // MARK: 不依赖libnuma, 直接使用系统调用; 内核不支持NUMA时返回ENOSYS, 忽略即可
+    unsigned long mask = 1ul << node;
+    if(::syscall(SYS_set_mempolicy, MPOL_PREFERRED, &mask, sizeof(mask) * 8) < 0) {
+        LOG_DEBUG("set_mempolicy failed, errno = {} {}.", errno, strerror(errno));
+        return false;
+    }
+    return true;
+}
@@ -1,17 +1,134 @@
 #include "mymuduo/net/Buffer.h"
 
+#include <algorithm>
 #include <cassert>
+#include <endian.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 using namespace mymuduo;
 using namespace mymuduo::net;
 
-Buffer::Buffer(std::size_t prependable_size, std::size_t writable_size) : 
+namespace mymuduo::net {
+namespace __detail {
+
+static constexpr char kCRLFCRLF[] = "\r\n\r\n";
+
+static const char* find_crlfcrlf_scalar(const char* begin, const char* end)
+{
+    while(end - begin >= 4)
+    {
+        // 先用memchr定位候选的'\r', 再比较完整的分割符
+        const void* p = ::memchr(begin, '\r', end - begin - 3);
+        if(!p) {
+            return nullptr;
+        }
+
+        const char* cand = static_cast<const char*>(p);
+        if(::memcmp(cand, kCRLFCRLF, 4) == 0) {
+            return cand;
+        }
+        begin = cand + 1;
+    }
+    return nullptr;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// MARK: 分别从 p, p+1, p+2, p+3 加载一个向量, 与"\r\n\r\n"的四个字节逐位比较,
+//       四个掩码相与后的第一个置位即为分割符的起始位置
+
+__attribute__((target("sse2")))
+static const char* find_crlfcrlf_sse2(const char* begin, const char* end)
+{
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    const char* p = begin;
+    for(; end - p >= 16 + 3; p += 16)
+    {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2));
+        __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 3));
+
+        __m128i m = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(b0, cr), _mm_cmpeq_epi8(b1, lf)),
+                                  _mm_and_si128(_mm_cmpeq_epi8(b2, cr), _mm_cmpeq_epi8(b3, lf)));
+
+        int mask = _mm_movemask_epi8(m);
+        if(mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return find_crlfcrlf_scalar(p, end);
+}
+
+__attribute__((target("avx2")))
+static const char* find_crlfcrlf_avx2(const char* begin, const char* end)
+{
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+
+    const char* p = begin;
+    for(; end - p >= 32 + 3; p += 32)
+    {
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 2));
+        __m256i b3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 3));
+
+        __m256i m = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(b0, cr), _mm256_cmpeq_epi8(b1, lf)),
+                                     _mm256_and_si256(_mm256_cmpeq_epi8(b2, cr), _mm256_cmpeq_epi8(b3, lf)));
+
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+        if(mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return find_crlfcrlf_sse2(p, end);
+}
+
+#endif
+
+using FindFunc = const char* (*)(const char*, const char*);
+
+static FindFunc select_find_crlfcrlf()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if(__builtin_cpu_supports("avx2")) {
+        return find_crlfcrlf_avx2;
+    }
+    if(__builtin_cpu_supports("sse2")) {
+        return find_crlfcrlf_sse2;
+    }
+#endif
+    return find_crlfcrlf_scalar;
+}
+
+const char* find_crlfcrlf(const char* begin, const char* end)
+{
+    // 只在第一次调用时检测CPU特性
+    static const FindFunc func = select_find_crlfcrlf();
+    return func(begin, end);
+}
+
+} // namespace __detail
+} // namespace mymuduo::net
+
+Buffer::Buffer(std::size_t prependable_size, std::size_t writable_size, std::shared_ptr<BufferPool> pool) : 
             _initial_prependable(prependable_size), _initial_writable(writable_size), 
             _read_idx(_initial_prependable), _write_idx(_initial_prependable),
-            _buf(_initial_prependable + _initial_writable)
-{ }
+            _buf(PoolAllocator<char>(std::move(pool)))
+{
+    // MARK: 绑定了内存池的缓冲区(连接的缓冲区)在loop线程第一次写入时才申请内存
+    if(!_buf.get_allocator().pool()) {
+        _buf.resize(_initial_prependable + _initial_writable);
+    }
+}
 
 Buffer::Buffer(const Buffer& other)
     : _initial_prependable(other._initial_prependable)
@@ -20,6 +137,8 @@ Buffer::Buffer(const Buffer& other)
     , _write_idx(other._write_idx)
     , _buf(other._buf)
     , _sep(other._sep)
+    , _scan_offset(other._scan_offset)
+    , _scan_delim(other._scan_delim)
 { }
 
 Buffer::Buffer(Buffer&& other) noexcept
@@ -29,10 +148,13 @@ Buffer::Buffer(Buffer&& other) noexcept
     , _write_idx(other._write_idx)
     , _buf(std::move(other._buf))
     , _sep(other._sep)
+    , _scan_offset(other._scan_offset)
+    , _scan_delim(std::move(other._scan_delim))
 {
     other._initial_prependable = other._initial_writable = 0;
     other._read_idx = other._write_idx = 0;
     other._sep = None;
+    other._scan_offset = 0;
 }
 
 Buffer& Buffer::operator= (const Buffer& other) {
@@ -42,6 +164,8 @@ Buffer& Buffer::operator= (const Buffer& other) {
     _write_idx = other._write_idx;
     _buf = other._buf;
     _sep = other._sep;
+    _scan_offset = other._scan_offset;
+    _scan_delim = other._scan_delim;
     return *this;
 }
 
@@ -52,6 +176,8 @@ Buffer& Buffer::operator= (Buffer&& other) {
     _write_idx = other._write_idx;
     _buf = std::move(other._buf);
     _sep = other._sep;
+    _scan_offset = other._scan_offset;
+    _scan_delim = std::move(other._scan_delim);
     return *this;
 }
 
@@ -100,6 +226,38 @@ void Buffer::append(const std::string& msg) {
     append(msg.data(), msg.size());
 }
 
+void Buffer::prepend(const void* data, std::size_t len)
+{
+    assert(len <= prependable());
+
+    // 归还过内存的缓冲区先恢复到初始大小
+    if(released()) {
+        grow(_initial_prependable + _initial_writable);
+    }
+
+    _read_idx -= len;
+    const char* d = static_cast<const char*>(data);
+    std::copy(d, d + len, begin() + _read_idx);
+
+    // 新写入的字节中可能含有分割符, 扫描断点需要从头开始
+    _scan_offset = 0;
+}
+
+void Buffer::prepend_int16(uint16_t x) {
+    uint16_t be = ::htobe16(x);
+    prepend(&be, sizeof be);
+}
+
+void Buffer::prepend_int32(uint32_t x) {
+    uint32_t be = ::htobe32(x);
+    prepend(&be, sizeof be);
+}
+
+void Buffer::prepend_int64(uint64_t x) {
+    uint64_t be = ::htobe64(x);
+    prepend(&be, sizeof be);
+}
+
 std::string Buffer::erase(std::size_t size)
 {
     // 不会有这种情况出现
@@ -111,6 +269,7 @@ std::string Buffer::erase(std::size_t size)
 
     // 将索引向后移动
     _read_idx += size;
+    _scan_offset = _scan_offset > size ? _scan_offset - size : 0;
 
     // 若移动后, payload大小为0, 则重置索引
     if(readable() == 0) {
@@ -120,7 +279,7 @@ std::string Buffer::erase(std::size_t size)
     return res;
 }
 
-bool Buffer::pick_datagram(std::string& msg)
+bool Buffer::find_datagram(Frame& frame)
 {
     // 若可读区域大小为0, 失败
     if(readable() == 0)
@@ -130,12 +289,15 @@ bool Buffer::pick_datagram(std::string& msg)
     {
         case 0:
         {
-            msg = std::string{begin() + _read_idx, begin() + _write_idx};
-            erase(readable());
+            frame = { 0, readable(), readable() };
             break;
         }
         case 1:
         {
+            // 报文头不完整
+            if(readable() < 4)
+                return false;
+
             std::size_t len = 0; // 获取报文头部的长度
             memcpy(&len, _buf.data() + _read_idx, 4);
 
@@ -144,29 +306,18 @@ bool Buffer::pick_datagram(std::string& msg)
                 return false;
 
             // 跳过报文头, 只取报文内容
-            msg = {begin() + _read_idx + 4, len};
-            erase(len + 4); // 将该报文从缓冲区中删除
-
+            frame = { 4, len, len + 4 };
             break;
         }
         case 2:
         {
-            std::size_t len = std::string::npos;
-            for(std::size_t i = _read_idx; i + 3 < _write_idx; i++) {
-                if(std::string{begin() + i, begin() + i + 4} == "\r\n\r\n") {
-                    len = i;
-                    break;
-                }
-            }
-
-            // 没有找到分割符 或者 报文不完整
-            if(len == std::string::npos || readable() < len - _read_idx + 4)
-                return false;
+            std::size_t len = search("\r\n\r\n");
 
-            // 将报文放到msg中
-            msg = {begin() + _read_idx, begin() + len};
-            erase(len - _read_idx + 4);
+            // 没有找到分割符, 报文不完整
+            if(len == std::string_view::npos)
+                return false;
 
+            frame = { 0, len, len + 4 };
             break;
         }
     }
@@ -174,6 +325,61 @@ bool Buffer::pick_datagram(std::string& msg)
     return true;
 }
 
+std::size_t Buffer::search(std::string_view delim)
+{
+    assert(!delim.empty());
+
+    // MARK: 断点只对记录它的分割符有效, 换用其它分割符时从头扫描, 否则会跳过新分割符的匹配
+    if(delim != _scan_delim) {
+        _scan_delim.assign(delim);
+        _scan_offset = 0;
+    }
+
+    // 从上次的扫描断点继续, 已扫描过的字节不再重复比较
+    const char* start = begin() + _read_idx;
+    const char* last = begin() + _write_idx;
+    const char* from = start + _scan_offset;
+    const char* pos = nullptr;
+
+    if(delim == "\r\n\r\n") {
+        pos = __detail::find_crlfcrlf(from, last);
+    }
+    else if(from < last) {
+        pos = static_cast<const char*>(::memmem(from, last - from, delim.data(), delim.size()));
+    }
+
+    if(pos == nullptr) {
+        // 末尾 size-1 个字节可能是分割符的前缀, 下次需要重新比较
+        _scan_offset = readable() >= delim.size() ? readable() - delim.size() + 1 : 0;
+        return std::string_view::npos;
+    }
+    return pos - start;
+}
+
+bool Buffer::pick_datagram(std::string& msg)
+{
+    Frame frame;
+    if(!find_datagram(frame))
+        return false;
+
+    // 将报文放到msg中, 再将其从缓冲区中删除
+    msg.assign(begin() + _read_idx + frame.body_offset, frame.body_len);
+    retrieve(frame.frame_len);
+    return true;
+}
+
+bool Buffer::pick_datagram(std::string_view& msg)
+{
+    Frame frame;
+    if(!find_datagram(frame))
+        return false;
+
+    // MARK: retrieve只移动索引, 不会改动数据, 故视图在缓冲区下一次被修改、释放或收缩之前有效
+    msg = { begin() + _read_idx + frame.body_offset, frame.body_len };
+    retrieve(frame.frame_len);
+    return true;
+}
+
 void Buffer::ensure_writable(std::size_t size)
 {
     // 确保可写区域有size的大小, 否则扩容
@@ -191,8 +397,8 @@ void Buffer::resize(std::size_t len)
     // 当writable和读空下来的prependable不够时, 重新分配
     if(writable() + prependable() < len + _initial_prependable) 
     {
-        // 重新分配空间
-        _buf.resize(_write_idx + len);
+        // 重新分配空间, 归还过内存的缓冲区至少恢复到初始大小
+        grow(std::max(_write_idx + len, _initial_prependable + _initial_writable));
     }
     else // 空下来的大小足够分配
     {
@@ -209,12 +415,78 @@ void Buffer::resize(std::size_t len)
     }
 }
 
+std::size_t Buffer::alloc_size(std::size_t size) const
+{
+    return _buf.get_allocator().pool() ? BufferPool::block_size(size) : size;
+}
+
+void Buffer::grow(std::size_t size)
+{
+    // MARK: 内存池按级别整块借出, 而vector只知道自己申请的大小; 直接按整块申请, 多出的部分才能被使用,
+    //       capacity也与实际占用的内存一致. 级别本身按2的幂增长, 不影响均摊;
+    //       超过最大级别时内存池按原大小申请, 仍由vector自己按倍数扩容
+    if(_buf.get_allocator().pool() && size <= BufferPool::kMaxBlockSize) {
+        size = alloc_size(size);
+        _buf.reserve(size);
+    }
+    _buf.resize(size);
+}
+
+bool Buffer::release()
+{
+    if(readable() != 0) {
+        return false;
+    }
+
+    // MARK: 与空vector交换才能真正释放内存, clear只会重置size
+    decltype(_buf) empty(_buf.get_allocator());
+    _buf.swap(empty);
+
+    _read_idx = _write_idx = _initial_prependable;
+    _scan_offset = 0;
+    return true;
+}
+
+void Buffer::shrink(std::size_t reserve)
+{
+    if(released()) {
+        return;
+    }
+
+    // 空的缓冲区直接归还全部内存
+    if(readable() == 0 && _buf.get_allocator().pool()) {
+        release();
+        return;
+    }
+
+    const std::size_t readable_bytes = readable();
+
+    // 在新的内存中只保留payload, 再与原缓冲区交换
+    decltype(_buf) other(_buf.get_allocator());
+    other.resize(alloc_size(_initial_prependable + readable_bytes + reserve));
+    std::copy(begin() + _read_idx, begin() + _write_idx, other.data() + _initial_prependable);
+    _buf.swap(other);
+
+    _read_idx = _initial_prependable;
+    _write_idx = _read_idx + readable_bytes;
+}
+
 std::size_t Buffer::read_fd(int fd, int* save_errno)
 {
     // MARK: 一开始不知道input缓冲区是否会因为空间不足而溢出
     //       故开辟栈上缓冲, 扩容后再将其拷贝给input缓冲
+    //       readv只会覆盖实际读到的部分, 所以无需清零
 
-    char extrabuf[65536] = {0};  // 临时缓冲区
+    char extrabuf[65536];  // 临时缓冲区
+    return read_fd(fd, save_errno, extrabuf, sizeof(extrabuf));
+}
+
+std::size_t Buffer::read_fd(int fd, int* save_errno, char* extrabuf, std::size_t extrabuf_size)
+{
+    // 内存已归还, 先重新申请初始大小
+    if(released()) {
+        ensure_writable(_initial_writable);
+    }
 
     struct iovec iov[2];
     const std::size_t write_bytes = writable();
@@ -224,10 +496,10 @@ std::size_t Buffer::read_fd(int fd, int* save_errno)
     iov[0].iov_len = write_bytes;
 
     iov[1].iov_base = extrabuf;
-    iov[1].iov_len = sizeof(extrabuf);
+    iov[1].iov_len = extrabuf_size;
 
     // 如果 buffer 的可写区域大于 extrabuf, 那么忽略 extrabuf
-    const int iov_count = (write_bytes < sizeof(extrabuf)) ? 2 : 1;
+    const int iov_count = (write_bytes < extrabuf_size) ? 2 : 1;
 
     ssize_t nlen = ::readv(fd, iov, iov_count);
     // error
@@ -243,8 +515,8 @@ std::size_t Buffer::read_fd(int fd, int* save_errno)
     else 
     {
         _write_idx = _buf.size();
-        // 将extrabuf中的数据追加至缓冲区中(会触发resize)
-        append_with_sep(extrabuf, nlen - write_bytes);
+        // 将extrabuf中的数据原样追加至缓冲区中(会触发resize), 接收路径不能添加分割符
+        append(extrabuf, nlen - write_bytes);
     }
     return nlen;
 }
@@ -261,6 +533,7 @@ std::size_t Buffer::write_fd(int fd, int* save_errno)
     // 调整索引
     else {
         _read_idx += len;
+        _scan_offset = _scan_offset > static_cast<std::size_t>(len) ? _scan_offset - len : 0;
     }
 
     return len;
@@ -270,6 +543,7 @@ void Buffer::retrieve(size_t len)
 {
     if(len < readable()) {
         _read_idx += len;
+        _scan_offset = _scan_offset > len ? _scan_offset - len : 0;
     }
     else {
         retrieve_all();
@@ -278,6 +552,7 @@ void Buffer::retrieve(size_t len)
 
 void Buffer::retrieve_all() {
     _read_idx = _write_idx = _initial_prependable;
+    _scan_offset = 0;
 }
 
 std::string Buffer::retrieve_as_string(size_t len) {
@@ -0,0 +1,85 @@
+#include "mymuduo/base/CurrentThread.h"
+#include "mymuduo/net/BufferPool.h"
+
+#include <bit>
+#include <cassert>
+#include <new>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+BufferPool::BufferPool(pid_t owner_tid) : _owner_tid(owner_tid) { }
+
+BufferPool::~BufferPool()
+{
+    for(std::size_t i = 0; i < kNumClasses; ++i) {
+        for(void* p : _free_lists[i]) {
+            ::operator delete(p);
+        }
+    }
+}
+
+std::size_t BufferPool::class_index(std::size_t size)
+{
+    assert(size <= kMaxBlockSize);
+
+    // 不足最小级别的按最小级别处理
+    std::size_t shift = std::bit_width(size > 1 ? size - 1 : 1);
+    return shift <= kMinClassShift ? 0 : shift - kMinClassShift;
+}
+
+std::size_t BufferPool::block_size(std::size_t size)
+{
+    if(size > kMaxBlockSize) {
+        return size;
+    }
+    return kMinBlockSize << class_index(size);
+}
+
+bool BufferPool::in_owner_thread() const {
+    return CurrentThread::tid() == _owner_tid;
+}
+
+void* BufferPool::allocate(std::size_t size)
+{
+    const std::size_t bytes = block_size(size);
+
+    // 超过最大级别, 或者不在owner线程中, 直接申请
+    if(size > kMaxBlockSize || !in_owner_thread()) {
+        return ::operator new(bytes);
+    }
+
+    std::vector<void*>& list = _free_lists[class_index(size)];
+    if(list.empty()) {
+        return ::operator new(bytes);
+    }
+
+    void* p = list.back();
+    list.pop_back();
+    _cached_bytes -= bytes;
+    return p;
+}
+
+void BufferPool::deallocate(void* p, std::size_t size)
+{
+    if(p == nullptr) {
+        return;
+    }
+
+    const std::size_t bytes = block_size(size);
+
+    if(size > kMaxBlockSize || !in_owner_thread()) {
+        ::operator delete(p);
+        return;
+    }
+
+    // 该级别缓存已满, 直接释放
+    std::vector<void*>& list = _free_lists[class_index(size)];
+    if((list.size() + 1) * bytes > kMaxCachedBytesPerClass) {
+        ::operator delete(p);
+        return;
+    }
+
+    list.emplace_back(p);
+    _cached_bytes += bytes;
+}
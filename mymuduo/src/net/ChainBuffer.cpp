@@ -0,0 +1,247 @@
+#include "mymuduo/net/ChainBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <sys/uio.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+ChainBuffer::ChainBuffer(std::shared_ptr<BufferPool> pool) : _pool(std::move(pool)) { }
+
+ChainBuffer::ChainBuffer(ChainBuffer&& other) noexcept
+    : _pool(std::move(other._pool))
+    , _blocks(std::move(other._blocks))
+    , _spare(std::move(other._spare))
+    , _readable(other._readable)
+{
+    other._blocks.clear();
+    other._spare.clear();
+    other._readable = 0;
+}
+
+ChainBuffer& ChainBuffer::operator= (ChainBuffer&& other) noexcept {
+    if(this != &other) {
+        clear();
+        _pool = std::move(other._pool);
+        _blocks = std::move(other._blocks);
+        _spare = std::move(other._spare);
+        _readable = other._readable;
+
+        other._blocks.clear();
+        other._spare.clear();
+        other._readable = 0;
+    }
+    return *this;
+}
+
+ChainBuffer::~ChainBuffer() {
+    clear();
+}
+
+void ChainBuffer::append(const char* data, std::size_t size)
+{
+    assert(data != nullptr || size == 0);
+
+    while(size > 0)
+    {
+        // 尾块写满或者还没有块时, 追加新块
+        if(_blocks.empty() || _blocks.back().writable() == 0) {
+            new_block();
+        }
+
+        Block& tail = _blocks.back();
+        std::size_t n = std::min(size, tail.writable());
+        std::copy(data, data + n, tail.data + tail.write_idx);
+
+        tail.write_idx += n;
+        _readable += n;
+        data += n;
+        size -= n;
+    }
+}
+
+void ChainBuffer::append(const std::string& msg) {
+    append(msg.data(), msg.size());
+}
+
+ssize_t ChainBuffer::write_fd(int fd, int* save_errno, std::size_t max_len)
+{
+    struct iovec iov[kMaxIovecs];
+    int iov_count = fill_iovecs(iov, max_len);
+
+    if(iov_count == 0) {
+        return 0;
+    }
+
+    ssize_t len = ::writev(fd, iov, iov_count);
+    if(len < 0) {
+        *save_errno = errno;
+    }
+    else {
+        retrieve(len);
+    }
+
+    return len;
+}
+
+int ChainBuffer::fill_iovecs(struct iovec* iov, std::size_t max_len, std::vector<std::shared_ptr<PinnedBlock>>* pins)
+{
+    int iov_count = 0;
+
+    for(Block& block : _blocks) {
+        if(iov_count == kMaxIovecs || max_len == 0) {
+            break;
+        }
+        if(block.readable() == 0) {
+            continue;
+        }
+        iov[iov_count].iov_base = block.data + block.read_idx;
+        iov[iov_count].iov_len = std::min(block.readable(), max_len);
+        max_len -= iov[iov_count].iov_len;
+        ++iov_count;
+
+        if(pins) {
+            if(!block.pinned) {
+                block.pinned = std::make_shared<PinnedBlock>(_pool, block.data);
+            }
+            pins->emplace_back(block.pinned);
+        }
+    }
+
+    return iov_count;
+}
+
+std::shared_ptr<const void> ChainBuffer::pin_iovecs(struct iovec* iov, int* iov_count, std::size_t max_len)
+{
+    std::vector<std::shared_ptr<PinnedBlock>> pins;
+    *iov_count = fill_iovecs(iov, max_len, &pins);
+
+    if(pins.empty()) {
+        return nullptr;
+    }
+    // 只有一个块时直接共享它的句柄, 否则由一个集合持有所有块的句柄
+    if(pins.size() == 1) {
+        return pins.front();
+    }
+    return std::make_shared<std::vector<std::shared_ptr<PinnedBlock>>>(std::move(pins));
+}
+
+ChainBuffer::PinnedBlock::~PinnedBlock()
+{
+    if(pool) {
+        pool->deallocate(data, kBlockSize);
+    }
+    else {
+        delete[] data;
+    }
+}
+
+void ChainBuffer::retrieve(std::size_t len)
+{
+    if(len >= _readable) {
+        retrieve_all();
+        return;
+    }
+
+    _readable -= len;
+    while(len > 0)
+    {
+        Block& head = _blocks.front();
+        std::size_t n = std::min(len, head.readable());
+        head.read_idx += n;
+        len -= n;
+
+        // 链首的块已读空, 将其释放
+        if(head.readable() == 0) {
+            pop_block();
+        }
+    }
+}
+
+void ChainBuffer::retrieve_all()
+{
+    while(!_blocks.empty()) {
+        pop_block();
+    }
+    _readable = 0;
+}
+
+std::string ChainBuffer::retrieve_all_as_string()
+{
+    std::string res;
+    res.reserve(_readable);
+    for(const Block& block : _blocks) {
+        res.append(block.data + block.read_idx, block.readable());
+    }
+    retrieve_all();
+    return res;
+}
+
+void ChainBuffer::shrink()
+{
+    for(char* data : _spare) {
+        delete[] data;
+    }
+    _spare.clear();
+}
+
+ChainBuffer::Block& ChainBuffer::new_block()
+{
+    Block block;
+    block.data = allocate_block();
+
+    _blocks.emplace_back(block);
+    return _blocks.back();
+}
+
+void ChainBuffer::pop_block()
+{
+    assert(!_blocks.empty());
+
+    // MARK: 被锁定的块不放回空闲列表或内存池, 由最后一个持有者归还
+    Block& head = _blocks.front();
+    if(!head.pinned) {
+        deallocate_block(head.data);
+    }
+    _blocks.pop_front();
+}
+
+char* ChainBuffer::allocate_block()
+{
+    if(_pool) {
+        return static_cast<char*>(_pool->allocate(kBlockSize));
+    }
+
+    if(!_spare.empty()) {
+        char* data = _spare.back();
+        _spare.pop_back();
+        return data;
+    }
+    return new char[kBlockSize];
+}
+
+void ChainBuffer::deallocate_block(char* data)
+{
+    // MARK: 绑定了内存池时, 块直接归还给内存池, 空闲的连接不会占用任何块
+    if(_pool) {
+        _pool->deallocate(data, kBlockSize);
+    }
+    else if(_spare.size() < kMaxSpareBlocks) {
+        _spare.emplace_back(data);
+    }
+    else {
+        delete[] data;
+    }
+}
+
+void ChainBuffer::clear()
+{
+    while(!_blocks.empty()) {
+        pop_block();
+    }
+    _readable = 0;
+
+    shrink();
+}
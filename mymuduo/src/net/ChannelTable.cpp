@@ -0,0 +1,41 @@
+#include "mymuduo/net/ChannelTable.h"
+#include "mymuduo/net/Channel.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+uint32_t ChannelTable::insert(Channel *ch)
+{
+    const int fd = ch->fd();
+    assert(fd >= 0);
+
+    if(static_cast<std::size_t>(fd) >= _slots.size()) {
+        // 按2倍扩容, 避免fd逐个增长时反复拷贝
+        _slots.resize(std::max<std::size_t>(fd + 1, _slots.size() * 2));
+    }
+
+    // MARK: 旧的Channel没有删除就析构时fd可能已被复用, 此时直接覆盖; 代数加一后旧Channel的事件不再匹配
+    Slot& slot = _slots[fd];
+    if(slot.ch == nullptr) {
+        ++_size;
+    }
+    slot.ch = ch;
+    return ++slot.generation;
+}
+
+void ChannelTable::erase(int fd)
+{
+    if(fd < 0 || static_cast<std::size_t>(fd) >= _slots.size() || _slots[fd].ch == nullptr) {
+        return;
+    }
+    _slots[fd].ch = nullptr;
+    --_size;
+}
+
+bool ChannelTable::contains(Channel *ch) const
+{
+    return find(ch->fd()) == ch;
+}
@@ -4,6 +4,7 @@
 #include "mymuduo/net/EventLoop.h"
 #include "mymuduo/net/SocketOps.h"
 
+#include <algorithm>
 #include <cassert>
 
 using namespace mymuduo;
@@ -39,7 +40,9 @@ EventLoop::EventLoop() :
         _poller(Poller::new_default_poller(this)),
         _timer_queue(new TimerQueue(this)),
         _wakeup_fd(__detail::create_eventfd()), 
-        _wakeup_channel(new Channel(this, _wakeup_fd))
+        _wakeup_channel(new Channel(this, _wakeup_fd)),
+        _scratch_buffer(new char[kScratchBufferSize]),
+        _buffer_pool(std::make_shared<BufferPool>(_tid))
 {
     LOG_DEBUG("EventLoop created {} in thread {}.", (void*)this, _tid);
 
@@ -83,15 +86,7 @@ void EventLoop::loop(std::chrono::system_clock::duration timeout)
 
     while(!_quit)
     {
-        _activeChannels.clear();
-        _poller_return_time = _poller->poll(&_activeChannels, timeout);
-
-        for(Channel *ch : _activeChannels) {
-            ch->handle(_poller_return_time);
-        }
-
-        // 用于执行task_queue中的任务
-        do_pending_functors();
+        poll_once(timeout);
     }
 
     LOG_INFO("EventLoop {} stop looping.", (void*)this);
@@ -108,19 +103,93 @@ void EventLoop::loop_once(std::chrono::system_clock::duration timeout)
 
     _looping = true;
 
+    poll_once(timeout);
+    _looping = false;
+
+
+    LOG_INFO("EventLoop {} stop looping.", (void*)this);
+}
+
+void EventLoop::poll_once(std::chrono::system_clock::duration timeout)
+{
     _activeChannels.clear();
+    const auto poll_start = std::chrono::steady_clock::now();
+
+    // 忙轮询期间不公布_polling, 生产者只入队不写eventfd, 由自旋循环检查任务队列
+    const auto busy_poll = this->busy_poll();
+    if(busy_poll.count() > 0 && timeout != std::chrono::system_clock::duration::zero()
+                             && spin_poll(busy_poll)) {
+        dispatch_active_channels(poll_start);
+        return;
+    }
+
+    // MARK: loop先公布即将阻塞, 再检查任务队列; 生产者先入队, 再检查loop是否即将阻塞(见wakeup)
+    //       两侧之间都有seq_cst屏障, 至少有一方能看到另一方的写入, 不会出现任务入队却无人唤醒
+    _polling.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // 包括上一轮超出预算而留下的任务
+    if(!_task_queue.empty() || _quit) {
+        timeout = std::chrono::system_clock::duration::zero();
+    }
+
     _poller_return_time = _poller->poll(&_activeChannels, timeout);
-    
+    _polling.store(false, std::memory_order_relaxed);
+
+    // 阻塞期间有事件到来, 说明loop重新活跃, 恢复一部分自旋时长
+    if(busy_poll.count() > 0 && !_activeChannels.empty()) {
+        _spin_budget = std::min(busy_poll, std::max(_spin_budget * 2, kMinSpinBudget));
+    }
+
+    dispatch_active_channels(poll_start);
+}
+
+bool EventLoop::spin_poll(std::chrono::microseconds max_budget)
+{
+    if(_spin_budget > max_budget) {
+        _spin_budget = max_budget;
+    }
+
+    // 自旋时长为0时也至少poll一次
+    const auto deadline = std::chrono::steady_clock::now() + _spin_budget;
+    do {
+        _poller_return_time = _poller->poll(&_activeChannels, std::chrono::system_clock::duration::zero());
+
+        if(!_activeChannels.empty() || !_task_queue.empty() || _quit) {
+            _spin_budget = std::min(max_budget, std::max(_spin_budget * 2, kMinSpinBudget));
+            return true;
+        }
+    } while(std::chrono::steady_clock::now() < deadline);
+
+    // 空转到期, loop处于空闲状态, 减少下一轮的自旋时长
+    _spin_budget /= 2;
+    return false;
+}
+
+void EventLoop::dispatch_active_channels(std::chrono::steady_clock::time_point poll_start)
+{
+    const auto handle_start = std::chrono::steady_clock::now();
+
     for(Channel *ch : _activeChannels) {
         ch->handle(_poller_return_time);
     }
 
+    const auto functors_start = std::chrono::steady_clock::now();
+
     // 用于执行task_queue中的任务
-    do_pending_functors();
-    _looping = false;
+    std::size_t drained = do_pending_functors();
 
+    _metrics.record_iteration(handle_start - poll_start, functors_start - handle_start,
+                              std::chrono::steady_clock::now() - functors_start,
+                              _activeChannels.size(), drained);
+}
 
-    LOG_INFO("EventLoop {} stop looping.", (void*)this);
+EventLoopMetrics::Snapshot EventLoop::metrics() const
+{
+    EventLoopMetrics::Snapshot s = _metrics.snapshot();
+    s.task_backlog = _task_queue.size();
+    s.wakeup_writes = wakeup_writes();
+    return s;
 }
 
 void EventLoop::quit() 
@@ -147,49 +216,49 @@ void EventLoop::handle_read()
     if(len != sizeof(one)) {
         LOG_WARN("EventLoop::handle_eventfd() reads {} bytes instead of 8.", len);
     }
+
+    // 允许下一轮poll再次被唤醒; 用交换与唤醒方同步, 保证其之前入队的任务在本轮可见
+    _wakeup_pending.exchange(false, std::memory_order_acq_rel);
 }
 
-void EventLoop::do_pending_functors()
+std::size_t EventLoop::do_pending_functors()
 {
-    // 设置局部queue, 将其与_task_queue交换
-    std::vector<Functor> functors;
     _calling_pending_functors = true;
 
-    ///////////////////////////////////////////////////
-    {
-        std::unique_lock<std::mutex> grd(_queue_mutex);
-        functors.swap(_task_queue);
+    // MARK: 只执行进入时已在队列中的任务, 任务中再投递的任务留到下一轮, 
+    //       否则不断投递任务的线程会让loop无法回到poll
+    std::size_t count = _task_queue.size();
+
+    // 超出预算的任务留到下一轮, 避免大量任务推迟本loop上所有连接的I/O
+    const std::size_t max_tasks = _task_budget_count.load(std::memory_order_relaxed);
+    if(max_tasks > 0 && count > max_tasks) {
+        count = max_tasks;
     }
-    ///////////////////////////////////////////////////
+
+    const int64_t max_us = _task_budget_us.load(std::memory_order_relaxed);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(max_us);
+
+    std::size_t drained = 0;
+    Functor func;
 
     // 处理任务队列中的所有任务
-    for(const Functor &func : functors) {
+    while(drained < count && _task_queue.pop(func)) {
         func();
-    }
-
-    _calling_pending_functors = false;
-}
+        func = nullptr;     // 及时释放任务捕获的对象(如TcpConnectionPtr)
+        ++drained;
 
-void EventLoop::run_in_loop(Functor task)
-{
-    // 在当前loop对应的线程中执行任务
-    if(is_loop_thread()) {
-        task();
+        if(max_us > 0 && drained % kTaskBudgetCheckInterval == 0
+                      && std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
     }
 
-    // 在非当前loop线程中执行任务
-    else {
-        queue_in_loop(std::move(task));
-    }
+    _calling_pending_functors = false;
+    return drained;
 }
 
-void EventLoop::queue_in_loop(Functor task) 
+void EventLoop::after_queued()
 {
-    {   
-        std::lock_guard<std::mutex> lock(_queue_mutex);
-        _task_queue.emplace_back(task);
-    }
-
     // 1. 若当前不是EventLoop线程, 则唤醒对应的Loop线程
     // 2. 若当前是EventLoop线程, 但是其正在执行任务队列的任务, 那么防止线程之后被阻塞, 也应该wakeup
     if(!is_loop_thread() || _calling_pending_functors) {
@@ -200,6 +269,21 @@ void EventLoop::queue_in_loop(Functor task)
 // 让该事件循环触发读事件, 从而可以执行对应Channel的回调函数
 void EventLoop::wakeup()
 {
+    // 与poll_once中的屏障配对
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // loop没有阻塞在poll中, 它在阻塞前会检查任务队列, 无需唤醒
+    if(!_polling.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    // 本轮poll已经有线程写过eventfd
+    if(_wakeup_pending.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    _wakeup_writes.fetch_add(1, std::memory_order_relaxed);
+
     // 当前loop对应的线程就会被唤醒
     uint64_t one = 1;
     size_t len = ::write(_wakeup_fd, &one, sizeof(one));
@@ -1,3 +1,4 @@
+#include "mymuduo/base/CpuTopology.h"
 #include "mymuduo/base/Logger.h"
 #include "mymuduo/net/EventLoopThread.h"
 #include "mymuduo/net/EventLoop.h"
@@ -78,6 +79,14 @@ void EventLoopThread::stop_loop() {
 }
 
 void EventLoopThread::thread_func() {
+
+    // 先确定线程的位置, 之后EventLoop(及其内存池)申请的内存才会落在本地节点上
+    if(!_placement.cpus.empty()) {
+        CpuTopology::pin_current_thread(_placement.cpus);
+    }
+    if(_placement.node >= 0) {
+        CpuTopology::prefer_memory_node(_placement.node);
+    }
     
     // 将EventLoop声明为栈对象, 这样在线程退出时, EventLoop会自动析构
     EventLoop loop;
@@ -2,6 +2,9 @@
 #include "mymuduo/net/EventLoopThread.h"
 #include "mymuduo/net/EventLoopThreadPool.h"
 
+#include <map>
+#include <tuple>
+
 using namespace mymuduo;
 using namespace mymuduo::net;
 
@@ -17,11 +20,19 @@ EventLoopThreadPool::~EventLoopThreadPool() {
 void EventLoopThreadPool::start(const ThreadInitCallback &cb) {
     _started = true;
 
+    std::vector<LoopPlacement> placements;
+    if(_placement != PlacementPolicy::kNone && _num_threads > 0) {
+        placements = plan_placement(CpuTopology::detect(), _placement, _num_threads);
+    }
+
     for(int i = 0; i < _num_threads; i++) {
         char buf[_name.size() + 32];
         snprintf(buf, sizeof(buf), "%s%d", _name.c_str(), i);
 
         EventLoopThread *thread = new EventLoopThread(cb, _name);
+        if(i < static_cast<int>(placements.size())) {
+            thread->set_placement(placements[i]);
+        }
         _threads.emplace_back(std::unique_ptr<EventLoopThread>(thread));
         _sub_loops.emplace_back(thread->start_loop());
     }
@@ -29,6 +40,37 @@ void EventLoopThreadPool::start(const ThreadInitCallback &cb) {
     if(_num_threads == 0 && cb) {
         cb(_main_loop);
     }
+
+    apply_busy_poll();
+}
+
+void EventLoopThreadPool::set_busy_poll(std::chrono::microseconds budget) {
+    _default_busy_poll = budget;
+    _busy_poll.clear();
+    apply_busy_poll();
+}
+
+void EventLoopThreadPool::set_busy_poll(int index, std::chrono::microseconds budget) {
+    if(index < 0) {
+        return;
+    }
+    if(static_cast<std::size_t>(index) >= _busy_poll.size()) {
+        _busy_poll.resize(index + 1, _default_busy_poll);
+    }
+    _busy_poll[index] = budget;
+    apply_busy_poll();
+}
+
+void EventLoopThreadPool::apply_busy_poll() {
+    if(!_started) {
+        return;
+    }
+
+    // EventLoop::set_busy_poll 是线程安全的, 从loop运行时也可以直接设置
+    std::vector<EventLoop*> loops = get_all_loops();
+    for(std::size_t i = 0; i < loops.size(); ++i) {
+        loops[i]->set_busy_poll(i < _busy_poll.size() ? _busy_poll[i] : _default_busy_poll);
+    }
 }
 
 void EventLoopThreadPool::stop() {
@@ -43,6 +85,11 @@ void EventLoopThreadPool::stop() {
         // 会自动调用析构
         std::unique_ptr<EventLoopThread> thread = std::move(_threads[i]);
     }
+
+    // MARK: 从loop位于各自线程的栈上, 线程结束后就已析构, 不能再被 get_next_loop, metrics 等访问
+    _threads.clear();
+    _sub_loops.clear();
+    _next.store(0);
 }
 
 EventLoop* EventLoopThreadPool::get_next_loop() {
@@ -63,3 +110,64 @@ std::vector<EventLoop*> EventLoopThreadPool::get_all_loops() {
     return _sub_loops;
 }
 
+EventLoopMetrics::Snapshot EventLoopThreadPool::metrics() {
+    EventLoopMetrics::Snapshot total;
+    for(EventLoop* loop : get_all_loops()) {
+        total.merge(loop->metrics());
+    }
+    return total;
+}
+
+std::vector<LoopPlacement> EventLoopThreadPool::plan_placement(const CpuTopology& topo,
+                                                               PlacementPolicy policy, int num_loops)
+{
+    std::vector<LoopPlacement> placements;
+    if(policy == PlacementPolicy::kNone || topo.empty() || num_loops <= 0) {
+        return placements;
+    }
+
+    // 按NUMA节点分组; cpus() 已按节点, 插槽, 物理核排序, 同一物理核的超线程相邻
+    std::map<int, std::vector<LoopPlacement>> cores_by_node;
+    std::map<int, LoopPlacement> whole_node;
+    std::tuple<int, int, int> last_core { -1, -1, -1 };
+
+    for(const CpuTopology::Cpu& cpu : topo.cpus()) {
+        std::vector<LoopPlacement>& cores = cores_by_node[cpu.node];
+        std::tuple<int, int, int> core { cpu.node, cpu.package, cpu.core };
+        if(cores.empty() || core != last_core) {
+            cores.push_back(LoopPlacement{ {}, cpu.node });
+            last_core = core;
+        }
+        cores.back().cpus.push_back(cpu.id);
+
+        whole_node[cpu.node].node = cpu.node;
+        whole_node[cpu.node].cpus.push_back(cpu.id);
+    }
+
+    // 可选的位置: 依次轮流从各个节点取一个, 使loop均匀分布在各个节点上
+    std::vector<LoopPlacement> slots;
+    if(policy == PlacementPolicy::kPerNode) {
+        for(auto& [node, placement] : whole_node) {
+            slots.push_back(std::move(placement));
+        }
+    }
+    else {
+        for(std::size_t round = 0; ; ++round) {
+            bool taken = false;
+            for(auto& [node, cores] : cores_by_node) {
+                if(round < cores.size()) {
+                    slots.push_back(cores[round]);
+                    taken = true;
+                }
+            }
+            if(!taken) {
+                break;
+            }
+        }
+    }
+
+    for(int i = 0; i < num_loops; ++i) {
+        placements.push_back(slots[i % slots.size()]);
+    }
+    return placements;
+}
@@ -8,7 +8,6 @@ Poller::Poller(EventLoop *loop) : _owner_loop(loop) { }
 
 bool Poller::has_channel(Channel *ch) const
 {
-    auto it = _channel_map.find(ch->fd());
-    return it != _channel_map.end() && it->second == ch;
+    return _channel_table.contains(ch);
 }
 
@@ -48,6 +48,10 @@ void Socket::set_keep_alive(bool on) {
     sockets::setsockopt(_fd, SOL_SOCKET, SO_KEEPALIVE, on);
 }
 
+bool Socket::set_zero_copy(bool on) {
+    return sockets::setsockopt(_fd, SOL_SOCKET, SO_ZEROCOPY, on) == 0;
+}
+
 void Socket::set_reuse_addr(bool on) {
     sockets::setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, on);
 }
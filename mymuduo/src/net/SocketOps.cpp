@@ -23,7 +23,7 @@ int create_non_blocking_fd() {
 
 int setsockopt(int sockfd, int level, int optname, bool on) {
     int opt = on ? 1 : 0;
-    return ::setsockopt(sockfd, level, optname, &on, sizeof(opt));
+    return ::setsockopt(sockfd, level, optname, &opt, sizeof(opt));
 }
 
 void bind(int sockfd, struct sockaddr* addr) {
@@ -1,9 +1,18 @@
 #include "mymuduo/base/Logger.h"
 #include "mymuduo/net/TcpConnection.h"
 #include "mymuduo/net/EventLoop.h"
+#include "mymuduo/net/SocketOps.h"
+#include "mymuduo/net/poller/IoUringPoller.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <fcntl.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/sendfile.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
 
 using namespace mymuduo;
 using namespace mymuduo::net;
@@ -22,6 +31,10 @@ namespace __detail {
         return loop;
     }
 
+    // 输入缓冲区的初始大小, 两者之和恰好是内存池的最小级别
+    static constexpr std::size_t kInitialPrependable = 8;
+    static constexpr std::size_t kInitialWritable = BufferPool::kMinBlockSize - kInitialPrependable;
+
 } // namespace __detail
 
 void default_connection_callback(const TcpConnectionPtr& conn) {
@@ -47,9 +60,24 @@ TcpConnection::TcpConnection(EventLoop *loop, size_t id, const std::string &name
             _channel(new Channel(loop, clntfd)),
             _local_addr(localAddr),
             _peer_addr(clntAddr),
-            _input_buffer(),
-            _output_buffer(),
-            _high_water_mark(64*1024*1024)
+            _input_buffer(__detail::kInitialPrependable, __detail::kInitialWritable, loop->buffer_pool()),
+            _output_buffer(loop->buffer_pool()),
+            _output_file_bytes(0),
+            _relay_paused(false),
+            _completion_recv(false),
+            _uring(nullptr),
+            _uring_send(nullptr),
+            _sending(0),
+            _zerocopy_threshold(0),
+            _zerocopy_next_id(0),
+            _zerocopy_copied(0),
+            _high_water_mark(64*1024*1024),
+            _shrink_idle_reads(kDefaultShrinkIdleReads),
+            _shrink_idle_time(0),
+            _underused_reads(0),
+            _last_busy(Timestamp::now()),
+            _buffer_bytes(0),
+            _buffers_at_floor(true)
 {
     // 设置Connection被channel回调的四种函数
     _channel->set_write_callback(std::bind(&TcpConnection::handle_write, this));
@@ -74,6 +102,10 @@ TcpConnection::TcpConnection(EventLoop *loop, size_t id, const std::string &name
 
 TcpConnection::~TcpConnection()
 {
+    close_output_files();
+    if(_buffer_gauge) {
+        _buffer_gauge->fetch_sub(_buffer_bytes.load(), std::memory_order_relaxed);
+    }
     LOG_INFO("TcpConnection::dtor[{}] at fd={} in thread#{}.", _name, _channel->fd(), CurrentThread::tid());
 }
 
@@ -91,6 +123,18 @@ void TcpConnection::established()
     
     _state = kConnected;
     _channel->tie(shared_from_this()); // 将该Connection与Channel绑定
+
+    // loop不使用io_uring或内核不支持时, 仍按就绪事件读取
+    if(_completion_recv) {
+        auto* uring = dynamic_cast<IoUringPoller*>(_loop->poller());
+        if(uring && uring->set_completion_recv(_channel.get(), true)) {
+            _uring = uring;
+            _channel->set_read_callback(std::bind(&TcpConnection::handle_read_completion, this, std::placeholders::_1));
+        }
+        if(_uring && uring->set_completion_send(_channel.get(), true)) {
+            _uring_send = uring;
+        }
+    }
     _channel->set_read_events();
 
     LOG_INFO("TcpConnection::established[{}] at fd={} in thread#{}.", _name, _channel->fd(), CurrentThread::tid());
@@ -125,12 +169,18 @@ void TcpConnection::handle_read_ET(Timestamp receieveTime)
 {
     assert(_loop->is_loop_thread());
 
+    if(_relay_out) {
+        handle_relay_read();
+        return;
+    }
+
     while(true) // 因为是ET模式, 所以要确保数据一次性读完
     {
         int save_error = 0;
 
         // 将数据直接读取到输入缓冲区
-        ssize_t nlen = _input_buffer.read_fd(_channel->fd(), &save_error);
+        ssize_t nlen = _input_buffer.read_fd(_channel->fd(), &save_error,
+                            _loop->scratch_buffer(), EventLoop::kScratchBufferSize);
 
         // 数据读取成功
         if(nlen > 0) 
@@ -150,6 +200,7 @@ void TcpConnection::handle_read_ET(Timestamp receieveTime)
         else if(nlen == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) 
         {
             _message_callback(shared_from_this(), &_input_buffer, receieveTime);
+            update_buffer_usage(receieveTime);
             break;
         }
         // 连接断开
@@ -165,13 +216,20 @@ void TcpConnection::handle_read_LT(Timestamp receieveTime)
 {
     assert(_loop->is_loop_thread());
 
+    if(_relay_out) {
+        handle_relay_read();
+        return;
+    }
+
     int save_error = 0;
-    ssize_t nlen = _input_buffer.read_fd(_channel->fd(), &save_error);
+    ssize_t nlen = _input_buffer.read_fd(_channel->fd(), &save_error,
+                        _loop->scratch_buffer(), EventLoop::kScratchBufferSize);
 
     if(nlen > 0) {
         // MARK: 还要将接受到数据的缓冲区也交给上层服务器
         LOG_INFO("TcpConnection::handle_read[{}] at fd={} in thread#{}.", _name, _channel->fd(), CurrentThread::tid());
         _message_callback(shared_from_this(), &_input_buffer, receieveTime);
+        update_buffer_usage(receieveTime);
     }
     else if(nlen == 0) {
         LOG_INFO("TcpConnection::handle_close[{}] at fd={} in thread#{}.", _name, _channel->fd(), CurrentThread::tid());
@@ -184,6 +242,50 @@ void TcpConnection::handle_read_LT(Timestamp receieveTime)
     }
 }
 
+void TcpConnection::handle_read_completion(Timestamp receieveTime)
+{
+    assert(_loop->is_loop_thread());
+
+    // 数据已经由内核写入共享缓冲区, 这里只是拷贝到输入缓冲区, 不需要readv
+    ssize_t nlen = _uring->take_received(_channel.get(), &_input_buffer);
+    if(nlen > 0) {
+        _message_callback(shared_from_this(), &_input_buffer, receieveTime);
+
+        // MARK: 数据先由内核写入共享的缓冲区环, 输入缓冲区只用来把数据交给回调, 不承接readv;
+        //       回调取走了全部数据时立即归还, 空闲的连接不占用接收内存
+        if(_input_buffer.readable() == 0) {
+            _input_buffer.release();
+        }
+        update_buffer_usage(receieveTime);
+    }
+    else if(nlen == 0) {
+        LOG_INFO("TcpConnection::handle_close[{}] at fd={} in thread#{}.", _name, _channel->fd(), CurrentThread::tid());
+        handle_close();
+    }
+    else if(errno != EAGAIN) {
+        LOG_ERROR("TcpConnection::handle_error[{}] at fd={} in thread#{}.", _name, _channel->fd(), CurrentThread::tid());
+        handle_error();
+    }
+}
+
+void TcpConnection::stop_completion_recv()
+{
+    if(!completion_recv()) {
+        return;
+    }
+
+    while(_uring->take_received(_channel.get(), &_input_buffer) > 0) {}
+    _uring->set_completion_recv(_channel.get(), false);
+    _completion_recv = false;
+
+    if(_channel->get_monitored_events() & EPOLLET) {
+        _channel->set_read_callback(std::bind(&TcpConnection::handle_read_ET, this, std::placeholders::_1));
+    }
+    else {
+        _channel->set_read_callback(std::bind(&TcpConnection::handle_read_LT, this, std::placeholders::_1));
+    }
+}
+
 void TcpConnection::handle_write()
 {
     assert(_loop->is_loop_thread());
@@ -191,18 +293,17 @@ void TcpConnection::handle_write()
     if(_channel->is_writing())
     {
         int save_error = 0;
-        // 当可写后, 尝试把用户缓冲区的数据全部发送出去
-        ssize_t nlen = _output_buffer.write_fd(fd(), &save_error);
+        // 当可写后, 尝试把用户缓冲区和待发送的文件全部发送出去
         // 因为操作系统的原因(tcp滑动窗口), 数据不一定能全部接收, 剩下的数据等待下一次写事件触发
-
-        if(nlen < 0) {
+        // 完成式发送时写事件表示发送请求已完成, 先取出结果
+        if(!finish_send(&save_error) || !write_output(&save_error)) {
             LOG_WARN("{}:{}:{} TcpConnection::handle_write() error:{}.", 
                 __FILE__, __FUNCTION__, __LINE__, save_error);
         }
         else // 数据发送成功
         {
-            // 若发送后payload为0, 表示数据全部发送, 不再关注写事件
-            if(_output_buffer.readable() == 0) {
+            // 若发送后没有待发送的数据, 不再关注写事件
+            if(pending_output() == 0) {
 
                 // MARK: 将可写事件关闭掉, 防止在LT模式下内核一直触发而导致影响性能
                 _channel->unset_write_events();
@@ -217,6 +318,8 @@ void TcpConnection::handle_write()
                 shutdown_in_loop();
             }
         }
+
+        sync_buffer_gauge();
     }
     else
     {
@@ -224,6 +327,134 @@ void TcpConnection::handle_write()
     }
 }
 
+bool TcpConnection::write_output(int* save_errno)
+{
+    while(!_output_files.empty())
+    {
+        OutputFile& file = _output_files.front();
+
+        // 先发送排在该文件之前的数据
+        if(file.preceding > 0) {
+            ssize_t n = write_chain(save_errno, file.preceding);
+            if(n < 0) {
+                return *save_errno == EWOULDBLOCK;
+            }
+
+            file.preceding -= n;
+            if(file.preceding > 0) {
+                return true;    // socket已写满
+            }
+        }
+
+        ssize_t n = ::sendfile(fd(), file.fd, &file.offset, file.remaining);
+        if(n < 0) {
+            *save_errno = errno;
+            return errno == EWOULDBLOCK;
+        }
+
+        if(n == 0) {
+            // 文件比预期的短(被截断), 放弃剩余部分, 否则会一直触发写事件
+            LOG_WARN("TcpConnection::write_output[{}] file fd={} ended with {} bytes unsent.",
+                        _name, file.fd, file.remaining);
+            n = file.remaining;
+        }
+
+        file.remaining -= n;
+        _output_file_bytes -= n;
+        if(file.remaining > 0) {
+            return true;        // socket已写满
+        }
+
+        ::close(file.fd);
+        _output_files.pop_front();
+    }
+
+    if(_output_buffer.readable() > 0)
+    {
+        if(write_chain(save_errno) < 0) {
+            return *save_errno == EWOULDBLOCK;
+        }
+        if(_output_buffer.readable() > 0) {
+            return true;        // socket已写满
+        }
+    }
+
+    // 最后发送转发管道中的数据
+    if(_relay_in && _relay_in->bytes > 0)
+    {
+        ssize_t n = ::splice(_relay_in->fds[0], nullptr, fd(), nullptr, _relay_in->bytes,
+                             SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if(n < 0) {
+            *save_errno = errno;
+            return errno == EWOULDBLOCK;
+        }
+
+        _relay_in->bytes -= n;
+        if(auto source = _relay_source.lock()) {
+            source->resume_relay_read();
+        }
+    }
+    return true;
+}
+
+ssize_t TcpConnection::write_chain(int* save_errno, size_t max_len)
+{
+    if(!_uring_send) {
+        return _output_buffer.write_fd(fd(), save_errno, max_len);
+    }
+
+    // MARK: 同时只有一个发送请求, 否则请求之间没有先后顺序; 一个请求覆盖链首的多个块(与writev相同),
+    //       所有块在内核不再读取之前保持锁定
+    if(_sending == 0) {
+        struct iovec iov[ChainBuffer::kMaxIovecs];
+        int iov_count = 0;
+        auto holder = _output_buffer.pin_iovecs(iov, &iov_count, max_len);
+
+        size_t len = 0;
+        for(int i = 0; i < iov_count; ++i) {
+            len += iov[i].iov_len;
+        }
+        if(len > 0 && _uring_send->submit_send(_channel.get(), iov, iov_count, use_zero_copy(len), std::move(holder))) {
+            _sending = len;
+        }
+    }
+    return 0;
+}
+
+bool TcpConnection::finish_send(int* save_errno)
+{
+    if(_sending == 0) {
+        return true;
+    }
+
+    ssize_t n = _uring_send->take_sent(_channel.get());
+    if(n < 0) {
+        if(errno == EAGAIN) {
+            return true;
+        }
+        *save_errno = errno;
+        _sending = 0;
+        return false;
+    }
+
+    // 已发送的数据排在第一个文件之前(提交时的限制, 或文件在提交之后才加入)
+    _sending = 0;
+    _output_buffer.retrieve(n);
+    if(!_output_files.empty()) {
+        _output_files.front().preceding -= n;
+    }
+    return true;
+}
+
+void TcpConnection::close_output_files()
+{
+    for(const OutputFile& file : _output_files) {
+        ::close(file.fd);
+    }
+    _output_files.clear();
+    _output_file_bytes = 0;
+}
+
 // 在两个地方被调用: 1.channel的handle中; 2.channel回调的read_events中
 void TcpConnection::handle_close()
 {
@@ -250,6 +481,13 @@ void TcpConnection::handle_close()
 
 void TcpConnection::handle_error()
 {
+    // MARK: 零拷贝的完成通知也通过 EPOLLERR 送达, 取走通知后若socket没有真正的错误, 连接继续使用
+    if(!_zerocopy_pending.empty() && handle_zero_copy_completions()
+        && sockets::get_socket_error(fd()) == 0)
+    {
+        return;
+    }
+
     _state = kDisConnected;
 
     // 从事件循环中删除Channel
@@ -263,24 +501,132 @@ void TcpConnection::send(const std::string& message)
     if(_state == kConnected)
     {
         // 判断当前线程是否为IO线程
-        if(_loop->is_loop_thread()) // 若是IO线程, 直接执行send_a
+        if(_loop->is_loop_thread()) // 若是IO线程, 直接执行send_in_loop
         {
             send_in_loop(message.data(), message.size());
         }
         else // 若是工作线程, 交由IO线程执行
         {
-            // 添加到loop的任务队列中
-            _loop->run_in_loop(std::bind(&TcpConnection::send_in_loop, this, message.data(), message.size()));
+            // MARK: message可能在IO线程执行任务之前就被调用者销毁, 故拷贝一份交给IO线程
+            send(std::string(message));
+        }
+    }
+    else
+    {
+        LOG_DEBUG("TcpConnection {} had been disconnected or connecting.", fd());
+    }
+}
+
+void TcpConnection::send(std::string&& message)
+{
+    // 零拷贝发送时报文须存活到内核完成通知, 交给shared_ptr持有
+    if(use_zero_copy(message.size())) {
+        send(std::make_shared<const std::string>(std::move(message)));
+        return;
+    }
+
+    if(_state == kConnected)
+    {
+        if(_loop->is_loop_thread())
+        {
+            send_in_loop(message.data(), message.size());
+        }
+        else
+        {
+            // 报文的所有权随任务一起移交给IO线程
+            _loop->queue_in_loop([self = shared_from_this(), message = std::move(message)] {
+                self->send_in_loop(message.data(), message.size());
+            });
         }
     }
     else
     {
         LOG_DEBUG("TcpConnection {} had been disconnected or connecting.", fd());
     }
+}
 
+void TcpConnection::send(Buffer&& buf)
+{
+    if(use_zero_copy(buf.readable())) {
+        auto holder = std::make_shared<const Buffer>(std::move(buf));
+        send_owned(holder, holder->peek(), holder->readable());
+        return;
+    }
+
+    if(_state == kConnected)
+    {
+        if(_loop->is_loop_thread())
+        {
+            send_in_loop(buf.peek(), buf.readable());
+            buf.retrieve_all();
+        }
+        else
+        {
+            _loop->queue_in_loop([self = shared_from_this(), buf = std::move(buf)] {
+                self->send_in_loop(buf.peek(), buf.readable());
+            });
+        }
+    }
+    else
+    {
+        LOG_DEBUG("TcpConnection {} had been disconnected or connecting.", fd());
+    }
 }
 
-void TcpConnection::send_in_loop(const void *data, size_t len)
+void TcpConnection::send(std::shared_ptr<const std::string> message)
+{
+    if(message) {
+        const char* data = message->data();
+        const size_t len = message->size();
+        send_owned(std::move(message), data, len);
+    }
+}
+
+void TcpConnection::send_owned(std::shared_ptr<const void> holder, const void* data, size_t len)
+{
+    if(_state == kConnected)
+    {
+        if(_loop->is_loop_thread())
+        {
+            send_in_loop(data, len, std::move(holder));
+        }
+        else
+        {
+            _loop->queue_in_loop([self = shared_from_this(), holder = std::move(holder), data, len] {
+                self->send_in_loop(data, len, holder);
+            });
+        }
+    }
+    else
+    {
+        LOG_DEBUG("TcpConnection {} had been disconnected or connecting.", fd());
+    }
+}
+
+void TcpConnection::send(Buffer* buf)
+{
+    if(_state == kConnected)
+    {
+        if(_loop->is_loop_thread())
+        {
+            send_in_loop(buf->peek(), buf->readable());
+            buf->retrieve_all();
+        }
+        else
+        {
+            // MARK: buf属于调用者, 跨线程时须将数据拷贝一份交给IO线程
+            _loop->run_in_loop([self = shared_from_this(), message = buf->retrieve_all_as_string()] {
+                self->send_in_loop(message.data(), message.size());
+            });
+        }
+    }
+    else
+    {
+        LOG_DEBUG("TcpConnection {} had been disconnected or connecting.", fd());
+    }
+}
+
+void TcpConnection::send_in_loop(const void *data, size_t len, std::shared_ptr<const void> holder)
 {
     assert(_loop->is_loop_thread());
     
@@ -294,11 +640,25 @@ void TcpConnection::send_in_loop(const void *data, size_t len)
     size_t remaining = len;
     bool fault_error = false;
 
-    // 第一次发送数据, 或者缓冲区没有待发送数据
-    if(!_channel->is_writing() && _output_buffer.readable() == 0)
+    // 第一次发送数据, 或者缓冲区没有待发送数据; 完成式发送时数据都经过输出缓冲区, 由发送请求发送
+    if(!_uring_send && !_channel->is_writing() && pending_output() == 0)
     {
         // 先将数据直接写入fd
-        nwrote = ::write(_channel->fd(), data, len);
+        if(holder && use_zero_copy(len)) {
+            nwrote = ::send(_channel->fd(), data, len, MSG_ZEROCOPY);
+
+            // 锁定页面的配额(optmem)耗尽时退化为普通发送
+            if(nwrote < 0 && errno == ENOBUFS) {
+                nwrote = ::write(_channel->fd(), data, len);
+            }
+            // 每次成功的零拷贝发送都会被内核编号, 报文持有到该编号的完成通知到达
+            else if(nwrote > 0) {
+                _zerocopy_pending.emplace_back(_zerocopy_next_id++, std::move(holder));
+            }
+        }
+        else {
+            nwrote = ::write(_channel->fd(), data, len);
+        }
 
         if(nwrote > 0) {
             remaining = len - nwrote;
@@ -327,7 +687,7 @@ void TcpConnection::send_in_loop(const void *data, size_t len)
     if(!fault_error && remaining > 0)
     {
         // 发送缓冲区中剩余的待发送数据的长度
-        size_t oldLen = _output_buffer.readable();
+        size_t oldLen = pending_output();
 
         // 原本没有超过水位, 这次超过水位
         if(oldLen + remaining >= _high_water_mark
@@ -337,12 +697,403 @@ void TcpConnection::send_in_loop(const void *data, size_t len)
             _loop->run_in_loop(std::bind(_high_water_mark_callback, shared_from_this(), oldLen + remaining));
         }
 
-        _output_buffer.append_with_sep(std::string((char*)data, len));
+        // 只追加未发送的部分, 直接拷贝进链尾的块中
+        _output_buffer.append(static_cast<const char*>(data) + nwrote, remaining);
 
         // MARK: 若channel没有关注可写事件, 则关注
         if(!_channel->is_writing()) {
             _channel->set_write_events();
         }
+
+        // 没有进行中的发送请求时立即提交, 与本轮的其它请求一起进入内核
+        if(_uring_send && _sending == 0) {
+            int save_errno = 0;
+            write_output(&save_errno);
+        }
+
+        sync_buffer_gauge();
+    }
+}
+
+void TcpConnection::send_file(int fd, off_t offset, size_t length)
+{
+    if(_state != kConnected)
+    {
+        LOG_DEBUG("TcpConnection {} had been disconnected or connecting.", this->fd());
+        return;
+    }
+
+    // MARK: 文件可能在IO线程发送完之前就被调用者关闭, 故持有一份自己的fd
+    int file_fd = ::fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if(file_fd < 0) {
+        LOG_WARN("TcpConnection::send_file[{}] dup fd={} failed, errno={}.", _name, fd, errno);
+        return;
+    }
+
+    if(_loop->is_loop_thread()) {
+        send_file_in_loop(file_fd, offset, length);
+    }
+    else {
+        _loop->run_in_loop([self = shared_from_this(), file_fd, offset, length] {
+            self->send_file_in_loop(file_fd, offset, length);
+        });
+    }
+}
+
+void TcpConnection::send_file_in_loop(int file_fd, off_t offset, size_t length)
+{
+    assert(_loop->is_loop_thread());
+
+    if(_state == kDisConnected || length == 0)
+    {
+        if(_state == kDisConnected) {
+            LOG_WARN("disconnected, give up sending file.");
+        }
+        ::close(file_fd);
+        return;
+    }
+
+    size_t remaining = length;
+
+    // 没有待发送的数据时, 直接调用一次sendfile
+    if(!_channel->is_writing() && pending_output() == 0)
+    {
+        ssize_t n = ::sendfile(fd(), file_fd, &offset, remaining);
+        if(n > 0) {
+            remaining -= n;
+        }
+        else if(n < 0 && errno != EWOULDBLOCK) {
+            LOG_WARN("TcpConnection::send_file_in_loop sendfile to {} failed, errno={}.", fd(), errno);
+            ::close(file_fd);
+            return;
+        }
+
+        if(remaining == 0) {
+            ::close(file_fd);
+            if(_write_complete_callback) {
+                _loop->queue_in_loop(std::bind(_write_complete_callback, shared_from_this()));
+            }
+            return;
+        }
+    }
+
+    size_t oldLen = pending_output();
+    if(oldLen + remaining >= _high_water_mark
+        && oldLen < _high_water_mark
+        && _high_water_mark_callback)
+    {
+        _loop->run_in_loop(std::bind(_high_water_mark_callback, shared_from_this(), oldLen + remaining));
+    }
+
+    // 输出缓冲区中尚未排在其它文件之前的数据, 都要先于该文件发送
+    size_t preceding = _output_buffer.readable();
+    for(const OutputFile& file : _output_files) {
+        preceding -= file.preceding;
+    }
+
+    _output_files.push_back({ file_fd, offset, remaining, preceding });
+    _output_file_bytes += remaining;
+
+    if(!_channel->is_writing()) {
+        _channel->set_write_events();
+    }
+}
+
+void TcpConnection::relay(const TcpConnectionPtr& a, const TcpConnectionPtr& b)
+{
+    a->relay_to(b);
+    b->relay_to(a);
+}
+
+void TcpConnection::relay_to(const TcpConnectionPtr& peer)
+{
+    if(peer->loop() != _loop) {
+        LOG_ERROR("TcpConnection::relay_to[{}] peer {} belongs to another loop.", _name, peer->name());
+        return;
+    }
+
+    _loop->run_in_loop([self = shared_from_this(), peer] {
+        self->relay_to_in_loop(peer);
+    });
+}
+
+void TcpConnection::relay_to_in_loop(const TcpConnectionPtr& peer)
+{
+    assert(_loop->is_loop_thread());
+
+    if(_relay_out || _state != kConnected) {
+        return;
+    }
+
+    auto pipe = std::make_shared<RelayPipe>();
+    if(::pipe2(pipe->fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        LOG_ERROR("TcpConnection::relay_to[{}] create pipe failed, errno={}.", _name, errno);
+        return;
+    }
+
+    // 扩大管道以减少暂停读取的次数, 失败时沿用默认大小
+    ::fcntl(pipe->fds[1], F_SETPIPE_SZ, static_cast<int>(kRelayPipeSize));
+    pipe->capacity = ::fcntl(pipe->fds[1], F_GETPIPE_SZ);
+
+    // splice需要数据留在socket中
+    stop_completion_recv();
+
+    // 转发开始前已读入用户态的数据只能拷贝发送
+    if(_input_buffer.readable() > 0) {
+        peer->send_in_loop(_input_buffer.peek(), _input_buffer.readable());
+        _input_buffer.retrieve_all();
+    }
+
+    _relay_out = pipe;
+    _relay_peer = peer;
+    peer->_relay_in = std::move(pipe);
+    peer->_relay_source = weak_from_this();
+}
+
+void TcpConnection::handle_relay_read()
+{
+    auto peer = _relay_peer.lock();
+    if(!peer) {
+        // 转发目标已销毁, 丢弃读到的数据
+        LOG_WARN("TcpConnection::handle_relay_read[{}] relay peer is gone, closing.", _name);
+        handle_close();
+        return;
+    }
+
+    // MARK: 完成式接收停止前内核已经收到的数据排在socket中的数据之前, recv请求结束前不能splice
+    if(_uring && !relay_received(peer)) {
+        return;
+    }
+
+    RelayPipe& pipe = *_relay_out;
+
+    // ET模式下需要一直读到socket为空或管道写满
+    while(pipe.bytes < pipe.capacity)
+    {
+        ssize_t n = ::splice(fd(), nullptr, pipe.fds[1], nullptr, pipe.capacity - pipe.bytes,
+                             SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+        if(n > 0) {
+            pipe.bytes += n;
+            continue;
+        }
+
+        if(n == 0) {
+            // 对端关闭, 先把管道中的数据交给peer, 再关闭peer的写端
+            peer->flush_relay();
+            peer->shutdown();
+            handle_close();
+            return;
+        }
+
+        if(errno == EINTR) {
+            continue;
+        }
+        if(errno != EAGAIN) {
+            LOG_ERROR("TcpConnection::handle_relay_read[{}] splice failed, errno={}.", _name, errno);
+            handle_error();
+            return;
+        }
+
+        // MARK: EAGAIN 既可能是socket已读空, 也可能是管道的页槽已用完(字节数未到容量)
+        int unread = 0;
+        if(pipe.bytes == 0 || ::ioctl(fd(), FIONREAD, &unread) < 0 || unread == 0) {
+            break;
+        }
+
+        pipe.capacity = pipe.bytes;
+        break;
+    }
+
+    peer->flush_relay();
+
+    // 管道已满, 暂停读取, 等peer发送后恢复
+    if(_relay_out->bytes >= _relay_out->capacity && _channel->is_reading()) {
+        _relay_paused = true;
+        _channel->unset_read_events();
+    }
+}
+
+bool TcpConnection::relay_received(const TcpConnectionPtr& peer)
+{
+    ssize_t n;
+    while((n = _uring->take_received(_channel.get(), &_input_buffer)) > 0) {}
+    const int save_errno = errno;
+
+    if(_input_buffer.readable() > 0) {
+        peer->send_in_loop(_input_buffer.peek(), _input_buffer.readable());
+        _input_buffer.retrieve_all();
+    }
+
+    if(n == 0) {
+        peer->shutdown();
+        handle_close();
+        return false;
+    }
+    if(save_errno != EAGAIN) {
+        LOG_ERROR("TcpConnection::relay_received[{}] recv failed, errno={}.", _name, save_errno);
+        handle_error();
+        return false;
+    }
+
+    // 取消还未被内核确认, 之后可能还有数据
+    if(_uring->recv_pending(_channel.get())) {
+        return false;
+    }
+
+    _uring = nullptr;
+    return true;
+}
+
+void TcpConnection::flush_relay()
+{
+    // 正在关注写事件说明还有数据排在前面, 由handle_write按顺序发送
+    if(_state == kDisConnected || _channel->is_writing()) {
+        return;
+    }
+
+    int save_errno = 0;
+    if(!write_output(&save_errno)) {
+        LOG_WARN("TcpConnection::flush_relay[{}] write failed, errno={}.", _name, save_errno);
+        return;
+    }
+
+    if(pending_output() > 0) {
+        _channel->set_write_events();
+    }
+}
+
+void TcpConnection::resume_relay_read()
+{
+    if(!_relay_paused || _state != kConnected) {
+        return;
+    }
+
+    // 管道有空余后恢复按实际容量读取
+    if(_relay_out->bytes == 0) {
+        _relay_out->capacity = ::fcntl(_relay_out->fds[1], F_GETPIPE_SZ);
+    }
+
+    if(_relay_out->bytes < _relay_out->capacity) {
+        _relay_paused = false;
+        _channel->set_read_events();
+    }
+}
+
+bool TcpConnection::set_zero_copy(size_t threshold)
+{
+    // 修改的是loop中socket的选项
+    assert(_loop->is_loop_thread());
+
+    if(threshold > 0 && !_sock->set_zero_copy(true)) {
+        LOG_WARN("TcpConnection::set_zero_copy[{}] SO_ZEROCOPY is not supported, errno={}.", _name, errno);
+        _zerocopy_threshold.store(0, std::memory_order_relaxed);
+        return false;
+    }
+
+    _zerocopy_threshold.store(threshold, std::memory_order_relaxed);
+    return true;
+}
+
+bool TcpConnection::handle_zero_copy_completions()
+{
+    bool completed = false;
+
+    while(true)
+    {
+        char control[128];
+        struct msghdr msg{};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof control;
+
+        if(::recvmsg(fd(), &msg, MSG_ERRQUEUE) < 0) {
+            break;  // 错误队列已取空
+        }
+
+        for(struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm))
+        {
+            if(!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                && !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)) {
+                continue;
+            }
+
+            const auto* err = reinterpret_cast<const struct sock_extended_err*>(CMSG_DATA(cm));
+            if(err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+
+            // 一条通知覆盖编号 [ee_info, ee_data] 的多次发送
+            if(err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                _zerocopy_copied += err->ee_data - err->ee_info + 1;
+            }
+
+            while(!_zerocopy_pending.empty()
+                && static_cast<int32_t>(_zerocopy_pending.front().first - err->ee_data) <= 0) {
+                _zerocopy_pending.pop_front();
+            }
+            completed = true;
+        }
+    }
+
+    return completed;
+}
+
+void TcpConnection::update_buffer_usage(Timestamp receive_time)
+{
+    const size_t capacity = _input_buffer.capacity();
+
+    // 未超过初始大小, 或者使用率不低于1/4, 视为充分使用
+    if(capacity <= _input_buffer.initial_size() || _input_buffer.readable() * 4 >= capacity) {
+        _underused_reads = 0;
+        _last_busy = receive_time;
+    }
+    else if(_shrink_idle_reads > 0 && ++_underused_reads >= _shrink_idle_reads) {
+        shrink_buffers();
+    }
+
+    sync_buffer_gauge();
+}
+
+void TcpConnection::shrink_buffers_if_idle(Timestamp now)
+{
+    assert(_loop->is_loop_thread());
+
+    if(_shrink_idle_time.count() > 0 && now - _last_busy >= _shrink_idle_time) {
+        shrink_buffers();
+        sync_buffer_gauge();
+    }
+}
+
+void TcpConnection::shrink_buffers()
+{
+    LOG_DEBUG("TcpConnection::shrink_buffers[{}] input buffer capacity={} readable={}, output buffer capacity={}.",
+                _name, _input_buffer.capacity(), _input_buffer.readable(), _output_buffer.capacity());
+
+    // 只保留payload和初始的可写区域, 空的缓冲区会直接归还内存
+    _input_buffer.shrink(__detail::kInitialWritable);
+
+    // 输出缓冲区的块在发送完时就已释放(归还内存池), 这里只释放缓存的空闲块
+    _output_buffer.shrink();
+
+    _underused_reads = 0;
+    _last_busy = Timestamp::now();
+}
+
+void TcpConnection::sync_buffer_gauge()
+{
+    const size_t bytes = _input_buffer.capacity() + _output_buffer.capacity();
+    const size_t old = _buffer_bytes.exchange(bytes, std::memory_order_relaxed);
+
+    // 输入缓冲区为空时已归还内存, 否则只剩payload和初始的可写区域, 且输出缓冲区没有缓存的空闲块时, 收缩不会再释放内存
+    const bool input_at_floor = _input_buffer.readable() == 0
+                            ? _input_buffer.released()
+                            : _input_buffer.capacity() <= BufferPool::block_size(__detail::kInitialPrependable + _input_buffer.readable() + __detail::kInitialWritable);
+    const bool at_floor = input_at_floor
+                            && _output_buffer.capacity() == _output_buffer.num_blocks() * ChainBuffer::kBlockSize;
+    _buffers_at_floor.store(at_floor, std::memory_order_relaxed);
+
+    if(_buffer_gauge && bytes != old) {
+        _buffer_gauge->fetch_add(bytes - old, std::memory_order_relaxed);
     }
 }
 
@@ -6,6 +6,8 @@
 #include "mymuduo/net/SocketOps.h"
 
 #include <cassert>
+#include <unordered_map>
+#include <vector>
 
 using namespace mymuduo;
 using namespace mymuduo::net;
@@ -31,7 +33,10 @@ TcpServer::TcpServer(EventLoop *main_loop, const InetAddress &serv_addr,
         _name(name),
         _acceptor(new Acceptor(main_loop, serv_addr, option == kReusePort)),
         _loop_threads(new EventLoopThreadPool(main_loop, name)),
-        _next(1), _started(0), _stopping(false), _is_ET(is_ET)
+        _next(1), _started(0), _stopping(false), _is_ET(is_ET), _completion_recv(false),
+        _shrink_idle_reads(TcpConnection::kDefaultShrinkIdleReads),
+        _shrink_idle_time(0),
+        _buffer_gauge(std::make_shared<std::atomic<size_t>>(0))
 {
     _acceptor->set_new_connection_callback(std::bind(&TcpServer::new_connection, this,
                 std::placeholders::_1, std::placeholders::_2));
@@ -55,6 +60,12 @@ void TcpServer::start()
         
         // 启动主EventLoop
         _main_loop->run_in_loop(std::bind(&Acceptor::listen, _acceptor.get()));
+
+        // 定时回收空闲连接的缓冲区
+        if(_shrink_idle_time.count() > 0) {
+            _shrink_timer = _main_loop->run_every(_shrink_idle_time,
+                                std::bind(&TcpServer::shrink_idle_buffers, this));
+        }
     }
 }
 
@@ -65,6 +76,10 @@ void TcpServer::stop() {
 
     _stopping.store(true);
 
+    if(_shrink_idle_time.count() > 0) {
+        _main_loop->cancel(_shrink_timer);
+    }
+
     for(auto& item : _connections) {
         // MARK: 用临时的智能指针获取 TcpConnection 对象
         std::shared_ptr<TcpConnection> conn { item.second };
@@ -117,6 +132,9 @@ void TcpServer::new_connection(int clntfd, const InetAddress &clnt_addr)
     conn->set_message_callback(_message_callback);
     conn->set_write_complete_callback(_write_complete_callback);
     conn->set_close_callback(std::bind(&TcpServer::remove_connection, this, std::placeholders::_1));
+    conn->set_buffer_shrink_policy(_shrink_idle_reads, _shrink_idle_time);
+    conn->set_buffer_gauge(_buffer_gauge);
+    conn->set_completion_recv(_completion_recv);
 
     // 让对应的loop建立连接
     nextLoop->run_in_loop(std::bind(&TcpConnection::established, conn));
@@ -151,3 +169,27 @@ void TcpServer::remove_connection_in_loop(const TcpConnectionPtr &conn)
     conn->loop()->run_in_loop(std::bind(&TcpConnection::destroyed, conn));
 }
 
+void TcpServer::shrink_idle_buffers()
+{
+    assert(_main_loop->is_loop_thread());
+
+    // MARK: 按所属的loop将连接分组, 每个从loop只投递一个任务, 由它遍历自己的连接
+    //       缓冲区已经收缩到底的连接无需收缩, 直接跳过
+    std::unordered_map<EventLoop*, std::vector<TcpConnectionPtr>> loop_conns;
+    for(auto& item : _connections) {
+        const TcpConnectionPtr& conn = item.second;
+        if(!conn || conn->buffers_at_floor()) {
+            continue;
+        }
+        loop_conns[conn->loop()].emplace_back(conn);
+    }
+
+    Timestamp now = Timestamp::now();
+    for(auto& [loop, conns] : loop_conns) {
+        loop->run_in_loop([conns = std::move(conns), now]() {
+            for(const TcpConnectionPtr& conn : conns) {
+                conn->shrink_buffers_if_idle(now);
+            }
+        });
+    }
+}
@@ -6,7 +6,10 @@
 #include <stdlib.h>
 
 #include "mymuduo/net/Poller.h"
+#include "mymuduo/base/Logger.h"
 #include "mymuduo/net/poller/EPollPoller.h"
+#include "mymuduo/net/poller/IoUringPoller.h"
+#include "mymuduo/net/poller/PollPoller.h"
 
 using namespace mymuduo;
 using namespace mymuduo::net;
@@ -17,7 +20,18 @@ using namespace mymuduo::net;
 Poller* Poller::new_default_poller(EventLoop *loop)
 {
     if(::getenv("MUDUO_USE_POLL")) {
-        return nullptr;     // 生成Poll实例
+        return new PollPoller(loop);    // 生成Poll实例
+    }
+    else if(::getenv("MUDUO_USE_URING")) {
+        // 内核不支持io_uring(或缺少所需的特性)时回退到epoll
+        auto poller = new IoUringPoller(loop);
+        if(poller->valid()) {
+            return poller;
+        }
+
+        LOG_WARN("io_uring is not available, fall back to epoll.");
+        delete poller;
+        return new EPollPoller(loop);
     }
     else {
         return new EPollPoller(loop);  // 生成Epoll实例
@@ -3,6 +3,7 @@
 #include "mymuduo/net/Channel.h"
 #include "mymuduo/net/poller/EPollPoller.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <chrono>
@@ -14,7 +15,7 @@ using namespace mymuduo::net;
 EPollPoller::EPollPoller(EventLoop* loop) : 
         Poller(loop),
         _epoll_fd(::epoll_create1(EPOLL_CLOEXEC)) ,
-        _events_arr(_max_events)
+        _events_arr(kInitEvents)
 {
     if(_epoll_fd < 0) {
         LOG_ERROR("{}:{}:{} - errno = {} {}.", 
@@ -28,6 +29,8 @@ Timestamp EPollPoller::poll(ChannelList *activeChannels, std::chrono::system_clo
 
     LOG_DEBUG("func:{} => fd total count={}", __FUNCTION__, activeChannels->size());
 
+    flush_changes();
+
     Timestamp now = Timestamp::now();
     int numEvents = ::epoll_wait(_epoll_fd, _events_arr.data()
                         , static_cast<int>(_events_arr.size())
@@ -39,14 +42,8 @@ Timestamp EPollPoller::poll(ChannelList *activeChannels, std::chrono::system_clo
     {
         LOG_DEBUG("{} events happened.", numEvents);
         
-        // 通过epoll_event中的data获取channel指针(在add channel时设置)
+        // 通过epoll_event中的data获取channel(在add channel时设置)
         fill_active_channels(numEvents, activeChannels);
-
-        // 实际返回的numEvents和能够容纳的事件数相同, 那么扩容为原来的2倍
-        // 采用的是LT模式, 即使该次容量不够导致没有上报, 之后也会调用
-        if(numEvents == _events_arr.size() * 2) {
-            _events_arr.resize(_events_arr.size() * 2);
-        }
     }
     else if(numEvents < 0)
     {
@@ -65,14 +62,61 @@ Timestamp EPollPoller::poll(ChannelList *activeChannels, std::chrono::system_clo
         LOG_DEBUG("{} timeout!", __FUNCTION__);
     }
 
+    if(numEvents >= 0) {
+        _ready_events.record(numEvents);
+        adjust_events(numEvents);
+    }
+
     return now;
 }
 
+void EPollPoller::adjust_events(int numEvents)
+{
+    const std::size_t size = _events_arr.size();
+    const std::size_t max_events = _max_events.load(std::memory_order_relaxed);
+
+    // 上限被调小
+    if(size > max_events) {
+        _events_arr.resize(max_events);
+        _events_arr.shrink_to_fit();
+        _low_polls = 0;
+        return;
+    }
+
+    // MARK: 实际返回的numEvents和能够容纳的事件数相同, 说明还有就绪的fd没有取到, 扩容为原来的2倍;
+    // 采用的是LT模式, 即使该次容量不够导致没有上报, 下一轮也会取到
+    if(static_cast<std::size_t>(numEvents) == size) {
+        _saturated_polls.store(_saturated_polls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if(size < max_events) {
+            _events_arr.resize(std::min(size * 2, max_events));
+        }
+        _low_polls = 0;
+        return;
+    }
+
+    // 连续多轮占用不到四分之一才缩小, 避免就绪数在边界附近波动时反复分配
+    if(static_cast<std::size_t>(numEvents) * 4 >= size || size <= kInitEvents) {
+        _low_polls = 0;
+        return;
+    }
+    if(++_low_polls >= kShrinkAfter) {
+        _events_arr.resize(std::max(size / 2, kInitEvents));
+        _events_arr.shrink_to_fit();
+        _low_polls = 0;
+    }
+}
+
 void EPollPoller::fill_active_channels(int numEvents, ChannelList *activeChannels) const
 {
     for(int i = 0; i < numEvents; i++)
     {
-        Channel *ch = static_cast<Channel*>(_events_arr[i].data.ptr);
+        // 通过epoll_event中的fd与代数查找channel, 已被删除或fd已被新的channel复用时丢弃
+        const uint64_t tag = _events_arr[i].data.u64;
+        Channel *ch = _channel_table.find(static_cast<int>(tag & 0xffffffff), static_cast<uint32_t>(tag >> 32));
+        if(ch == nullptr) {
+            LOG_DEBUG("{} drop stale event, fd={}.", __FUNCTION__, static_cast<int>(tag & 0xffffffff));
+            continue;
+        }
         ch->set_happened_events(_events_arr[i].events);
         activeChannels->emplace_back(ch);
     }
@@ -84,32 +128,41 @@ void EPollPoller::update_channel(Channel* ch)
 
     LOG_INFO("func:{} => fd={} events={} status={}", __FUNCTION__, ch->fd(), ch->get_happened_events(), (int)status);
 
+    int fd = ch->fd();
+
     if(status == kNew || status == kDeleted) // 未注册或者已注册未监听
     {
-        int fd = ch->fd();
-
-        if(status == kNew) { // 若为新的channel, 将其注册到map中
-            _channel_map[fd] = ch;
+        if(status == kNew) { // 若为新的channel, 将其注册到表中
+            _channel_table.insert(ch);
         }
         else { // status == kDeleted, 即channel已注册, 但未被监听
-            assert(_channel_map.find(fd) != _channel_map.end());
-            assert(_channel_map[fd] == ch);
+            assert(_channel_table.find(fd) == ch);
         }
 
         ch->set_status(kAdded);
-        update(EPOLL_CTL_ADD, ch);  // 监听ch
     }
-    else  // 已被监听, 那么要修改
-    {
-        int fd = ch->fd();
+    else if(ch->is_none_events()) { // ch已被监听, 但要将其取消监听
+        ch->set_status(kDeleted);
+    }
 
-        if(ch->is_none_events()) {  // ch已被监听, 但要将其取消监听
-            update(EPOLL_CTL_DEL, ch);
-            ch->set_status(kDeleted);
-        }
-        else {
-            update(EPOLL_CTL_MOD, ch);
+    if(static_cast<std::size_t>(fd) >= _interests.size()) {
+        _interests.resize(_channel_table.capacity());
+    }
+    Interest& interest = _interests[fd];
+
+    // MARK: 取消所有事件后调用者可能在remove_channel之前就关闭fd, 此时推迟的DEL会作用在已关闭(甚至被复用)的fd上,
+    // 因此这种修改立即提交; 其余修改只记录, 在下一次 epoll_wait 前与内核中的状态比较后再提交
+    if(ch->is_none_events()) {
+        if(interest.registered != 0 && update(EPOLL_CTL_DEL, ch, 0)) {
+            interest.registered = 0;
         }
+        interest.dirty = false;     // 本轮之前的修改作废, Channel之后可能不经remove_channel就被析构
+        return;
+    }
+
+    if(!interest.dirty) {
+        interest.dirty = true;
+        _dirty.push_back(fd);
     }
 }
 
@@ -119,24 +172,61 @@ void EPollPoller::remove_channel(Channel* ch)
 
     LOG_INFO("func:{} => fd={} events={} status={}", __FUNCTION__, ch->fd(), ch->get_happened_events(), (int)status);
 
-    // 若channel已经被监听, 那么删除
-    if(status == kAdded) {
-        update(EPOLL_CTL_DEL, ch);
+    // MARK: 调用者随后会关闭fd, 因此不能推迟到下一轮; 只要内核中还注册着就立即删除
+    const int fd = ch->fd();
+    if(fd >= 0 && static_cast<std::size_t>(fd) < _interests.size()) {
+        if(_interests[fd].registered != 0) {
+            update(EPOLL_CTL_DEL, ch, 0);
+        }
+        _interests[fd] = Interest {};   // _dirty 中残留的fd在提交时跳过
     }
 
     // 将其取消注册
-    _channel_map.erase(ch->fd());
+    _channel_table.erase(fd);
     ch->set_status(kNew);
 }
 
-void EPollPoller::update(int op, Channel* ch)
+void EPollPoller::flush_changes()
+{
+    for(int fd : _dirty)
+    {
+        Interest& interest = _interests[fd];
+        if(!interest.dirty) {   // 已被remove_channel删除
+            continue;
+        }
+        interest.dirty = false;
+
+        Channel* ch = _channel_table.find(fd);
+        if(ch == nullptr) {
+            continue;
+        }
+        const uint32_t events = ch->is_none_events() ? 0 : ch->get_monitored_events();
+
+        // 同一轮内相互抵消的修改
+        if(events == interest.registered) {
+            continue;
+        }
+
+        const int op = interest.registered == 0 ? EPOLL_CTL_ADD
+                     : events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+        if(update(op, ch, events)) {
+            interest.registered = events;
+        }
+    }
+    _dirty.clear();
+}
+
+bool EPollPoller::update(int op, Channel* ch, uint32_t events)
 {
     epoll_event ev;
     bzero(&ev, sizeof(epoll_event));
 
-    ev.data.ptr = ch;
-    ev.events = ch->get_monitored_events();
+    // MARK: 不直接保存channel指针, 而是保存fd与注册时的代数, 在fill_active_channels中校验
+    ev.data.u64 = (static_cast<uint64_t>(_channel_table.generation(ch->fd())) << 32)
+                | static_cast<uint32_t>(ch->fd());
+    ev.events = events;
 
+    ++_ctl_calls;
     if(epoll_ctl(_epoll_fd, op, ch->fd(), &ev) == -1) {
         switch (op)
         {
@@ -155,7 +245,9 @@ void EPollPoller::update(int op, Channel* ch)
                 __FILE__, __FUNCTION__, __LINE__, errno, strerror(errno));
             break;
         }
+        return false;
     }
+    return true;
 }
 
 EPollPoller::~EPollPoller() {
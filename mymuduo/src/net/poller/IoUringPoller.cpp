@@ -0,0 +1,1003 @@
+#include "mymuduo/base/Logger.h"
+#include "mymuduo/net/Buffer.h"
+#include "mymuduo/net/Channel.h"
+#include "mymuduo/net/poller/IoUringPoller.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+namespace {
+
+// 与内核共享的索引需要原子地访问
+unsigned load_acquire(unsigned* p) {
+    return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+void store_release(unsigned* p, unsigned value) {
+    std::atomic_ref<unsigned>(*p).store(value, std::memory_order_release);
+}
+
+void store_release(uint16_t* p, uint16_t value) {
+    std::atomic_ref<uint16_t>(*p).store(value, std::memory_order_release);
+}
+
+constexpr uint32_t kReadEvents = EPOLLIN | EPOLLPRI;
+
+// 需要通过poll监听的事件, 完成式接收(或者recv请求还未结束)时读事件由recv请求负责, 发送请求进行中时写事件由它负责
+uint32_t poll_events(Channel* ch, bool by_recv, bool by_send) {
+    uint32_t events = ch->get_monitored_events() & ~static_cast<uint32_t>(EPOLLET);
+    if(by_recv) {
+        events &= ~kReadEvents;
+    }
+    if(by_send) {
+        events &= ~static_cast<uint32_t>(EPOLLOUT);
+    }
+    return events;
+}
+
+} // namespace
+
+IoUringPoller::IoUringPoller(EventLoop *loop) : Poller(loop)
+{
+    if(!setup()) {
+        teardown();
+    }
+}
+
+IoUringPoller::~IoUringPoller()
+{
+    teardown();
+}
+
+bool IoUringPoller::setup()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CLAMP;
+
+    _ring_fd = static_cast<int>(::syscall(SYS_io_uring_setup, kEntries, &params));
+    if(_ring_fd < 0) {
+        LOG_INFO("io_uring_setup failed, errno = {} {}.", errno, strerror(errno));
+        return false;
+    }
+
+    const unsigned required = IORING_FEAT_EXT_ARG | IORING_FEAT_POLL_32BITS | IORING_FEAT_NODROP;
+    if((params.features & required) != required) {
+        LOG_INFO("io_uring lacks required features {:#x}, have {:#x}.", required, params.features);
+        return false;
+    }
+
+    _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+    // 新内核中两个环形队列可以一次映射
+    const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(single_mmap) {
+        _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+    }
+
+    _sq_ring = ::mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+    if(_sq_ring == MAP_FAILED) {
+        _sq_ring = nullptr;
+        return false;
+    }
+
+    if(single_mmap) {
+        _cq_ring = _sq_ring;
+    }
+    else {
+        _cq_ring = ::mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+        if(_cq_ring == MAP_FAILED) {
+            _cq_ring = nullptr;
+            return false;
+        }
+    }
+
+    _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED) {
+        return false;
+    }
+    _sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(_sq_ring);
+    _sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    _sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    _sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    _sq_entries = params.sq_entries;
+    _sq_local_tail = *_sq_tail;
+
+    char* cq = static_cast<char*>(_cq_ring);
+    _cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    _cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    return true;
+}
+
+void IoUringPoller::teardown()
+{
+    // MARK: 关闭io_uring只是让内核稍后(由后台线程)取消进行中的请求, 在此之前内核仍可能发送_sends持有的内存,
+    //       或者向缓冲区池写入数据; 必须等这些请求结束后才能释放内存
+    const bool drained = cancel_all();
+
+    if(_sqes) {
+        ::munmap(_sqes, _sqes_size);
+        _sqes = nullptr;
+    }
+    if(_cq_ring && _cq_ring != _sq_ring) {
+        ::munmap(_cq_ring, _cq_ring_size);
+    }
+    if(_sq_ring) {
+        ::munmap(_sq_ring, _sq_ring_size);
+    }
+    _sq_ring = _cq_ring = nullptr;
+
+    if(_ring_fd >= 0) {
+        ::close(_ring_fd);
+        _ring_fd = -1;
+    }
+
+    if(!drained) {
+        // 内核可能还在使用这些内存, 宁可泄漏也不能释放
+        LOG_WARN("io_uring requests still in flight at teardown, leaking {} send buffers and the recv pool.", _sends.size());
+        new std::unordered_map<uint64_t, SendRequest>(std::move(_sends));
+        _buf_ring = nullptr;
+        _recv_pool = nullptr;
+    }
+    _sends.clear();
+
+    // 所有请求都已结束, 内核不会再读取缓冲区环, 也不会再写入缓冲区
+    if(_buf_ring) {
+        ::munmap(_buf_ring, kRecvBuffers * sizeof(io_uring_buf));
+        _buf_ring = nullptr;
+    }
+    if(_recv_pool) {
+        ::munmap(_recv_pool, kRecvBuffers * kRecvBufferSize);
+        _recv_pool = nullptr;
+    }
+}
+
+bool IoUringPoller::cancel_all()
+{
+    // 只有发送与recv请求会访问用户态的内存, poll请求随io_uring关闭即可
+    if(_sends.empty() && _recv_requests == 0) {
+        return true;
+    }
+
+    io_uring_sqe* sqe = get_sqe();
+    if(!sqe) {
+        return false;
+    }
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    sqe->user_data = kCancelTag;
+
+    // 只做内存相关的记录, Channel可能已经析构, 不能回调
+    auto drain = [this](const io_uring_cqe& cqe) {
+        if(cqe.user_data == kCancelTag || (cqe.flags & IORING_CQE_F_MORE)) {
+            return;
+        }
+        const uint32_t seq = static_cast<uint32_t>(cqe.user_data);
+        if(seq & kSendSeqBit) {
+            _sends.erase(cqe.user_data);
+        }
+        else if(seq & kRecvSeqBit) {
+            --_recv_requests;
+        }
+    };
+
+    for(const io_uring_cqe& cqe : _backlog) {
+        drain(cqe);
+    }
+    _backlog.clear();
+
+    // MARK: 零拷贝发送的完成通知要等协议栈释放数据, 对端迟迟不确认时可能很久, 所以只等待有限的时间
+    const auto deadline = std::chrono::steady_clock::now() + kCancelTimeout;
+    while(!_sends.empty() || _recv_requests > 0) {
+        const auto now = std::chrono::steady_clock::now();
+        if(now >= deadline) {
+            return false;
+        }
+
+        int ret = enter(true, true, std::chrono::duration_cast<std::chrono::system_clock::duration>(deadline - now));
+        if(ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY) {
+            LOG_ERROR("{}:{}:{} - errno = {} {}.",
+                __FILE__, __FUNCTION__, __LINE__, -ret, strerror(-ret));
+            return false;
+        }
+
+        unsigned head = *_cq_head;
+        const unsigned tail = load_acquire(_cq_tail);
+        for(; head != tail; ++head) {
+            drain(_cqes[head & _cq_mask]);
+        }
+        store_release(_cq_head, head);
+    }
+    return true;
+}
+
+Timestamp IoUringPoller::poll(ChannelList *activeChannels, std::chrono::system_clock::duration timeout)
+{
+    LOG_DEBUG("func:{} => fd total count={}", __FUNCTION__, _channel_table.size());
+
+    flush_changes();
+
+    // 完成队列中已有事件, 或者还有未取出的数据时不必等待; 超时为0时也要进入内核, 让内核处理已就绪的poll请求
+    const bool has_cqes = load_acquire(_cq_tail) != *_cq_head || !_backlog.empty();
+    const bool has_ready = !_ready.empty() && collect_ready(nullptr);
+    const bool wait = !has_cqes && !has_ready && timeout != std::chrono::system_clock::duration::zero();
+
+    if(!has_cqes || _sq_local_tail != *_sq_tail) {
+        int ret = enter(true, wait, timeout);
+        if(ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY) {
+            LOG_ERROR("{}:{}:{} - errno = {} {}.",
+                __FILE__, __FUNCTION__, __LINE__, -ret, strerror(-ret));
+        }
+    }
+
+    Timestamp now = Timestamp::now();
+    reap(activeChannels);
+
+    if(activeChannels->empty()) {
+        LOG_DEBUG("{} timeout!", __FUNCTION__);
+    }
+    return now;
+}
+
+int IoUringPoller::enter(bool get_events, bool wait, std::chrono::system_clock::duration timeout)
+{
+    using namespace std::chrono;
+
+    // 公布已填写的SQE
+    store_release(_sq_tail, _sq_local_tail);
+    const unsigned to_submit = _sq_local_tail - load_acquire(_sq_head);
+
+    unsigned flags = 0;
+    void* arg = nullptr;
+    std::size_t arg_size = 0;
+
+    io_uring_getevents_arg ext;
+    __kernel_timespec ts;
+
+    if(get_events) {
+        flags |= IORING_ENTER_GETEVENTS;
+    }
+
+    if(wait) {
+        if(timeout != system_clock::duration::max()) {
+            auto ns = duration_cast<nanoseconds>(timeout).count();
+            ts.tv_sec = ns / 1000000000;
+            ts.tv_nsec = ns % 1000000000;
+
+            std::memset(&ext, 0, sizeof(ext));
+            ext.ts = reinterpret_cast<uint64_t>(&ts);
+
+            flags |= IORING_ENTER_EXT_ARG;
+            arg = &ext;
+            arg_size = sizeof(ext);
+        }
+    }
+
+    ++_enter_calls;
+    int ret = static_cast<int>(::syscall(SYS_io_uring_enter, _ring_fd, to_submit,
+                                         wait ? 1 : 0, flags, arg, arg_size));
+    return ret < 0 ? -errno : ret;
+}
+
+io_uring_sqe* IoUringPoller::get_sqe()
+{
+    // MARK: 提交队列已满时先提交, 内核取走了SQE之后才能复用它的位置, 否则会覆盖还未提交的请求
+    while(_sq_local_tail - load_acquire(_sq_head) == _sq_entries) {
+        int ret = enter(false, false, std::chrono::system_clock::duration::zero());
+        if(ret > 0 || ret == -EINTR) {
+            continue;
+        }
+        // 完成队列已满, 内核暂不接受新的请求; 将完成事件移到 _backlog 中腾出空间, 下一次 reap 时按原顺序处理
+        if(ret == -EBUSY && stash_cqes() > 0) {
+            continue;
+        }
+
+        LOG_ERROR("{}:{}:{} submission queue is full, io_uring_enter returned {} {}.",
+            __FILE__, __FUNCTION__, __LINE__, ret, strerror(-ret));
+        return nullptr;
+    }
+
+    const unsigned index = _sq_local_tail & _sq_mask;
+    _sq_array[index] = index;
+    ++_sq_local_tail;
+
+    io_uring_sqe* sqe = &_sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+std::size_t IoUringPoller::stash_cqes()
+{
+    unsigned head = *_cq_head;
+    const unsigned tail = load_acquire(_cq_tail);
+    const std::size_t count = tail - head;
+
+    for(; head != tail; ++head) {
+        _backlog.push_back(_cqes[head & _cq_mask]);
+    }
+    store_release(_cq_head, head);
+    return count;
+}
+
+bool IoUringPoller::arm(int fd, PollState& state, uint32_t events, bool multishot)
+{
+    io_uring_sqe* sqe = get_sqe();
+    if(!sqe) {
+        return false;
+    }
+
+    state.seq = next_seq();
+    state.armed_events = events;
+    state.multishot = multishot;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = events;
+    sqe->len = multishot ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = make_tag(fd, state.seq);
+    return true;
+}
+
+bool IoUringPoller::cancel(uint64_t user_data)
+{
+    io_uring_sqe* sqe = get_sqe();
+    if(!sqe) {
+        return false;
+    }
+
+    // MARK: POLL_REMOVE只能找到poll请求, 找不到已经在等待数据的multishot recv; ASYNC_CANCEL按user_data取消任意请求
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = user_data;
+    sqe->user_data = kCancelTag;
+    return true;
+}
+
+void IoUringPoller::mark_dirty(int fd, PollState& state)
+{
+    if(!state.dirty) {
+        state.dirty = true;
+        _dirty.push_back(fd);
+    }
+}
+
+void IoUringPoller::flush_changes()
+{
+    // 先归还缓冲区, 同一批中重新提交的recv才能取到
+    flush_recycled();
+
+    // MARK: 取不到SQE的Channel重新标记, 下一轮再提交; 遍历的是交换出来的列表, 标记不会使迭代器失效
+    _flushing.swap(_dirty);
+    for(int fd : _flushing) {
+        PollState& state = _states[fd];
+        if(!state.dirty) {
+            continue;
+        }
+        state.dirty = false;
+
+        // 已被remove_channel删除
+        if(!state.ch) {
+            continue;
+        }
+        bool submitted = true;
+
+        // MARK: 取消所有事件的Channel可能没有调用remove_channel就被析构, 不再访问它
+        Channel* ch = state.ch;
+        const bool added = state.active;
+        const bool multishot = added && (ch->get_monitored_events() & EPOLLET);
+
+        // MARK: 取消的recv请求在内核确认之前仍可能收到数据, 确认后才能提交新的recv或改为监听读就绪事件, 否则数据会乱序
+        const bool want_recv = added && state.recv_mode && (ch->get_monitored_events() & kReadEvents);
+        if(want_recv && !state.recv_armed && !state.recv_eof && state.recv_error == 0) {
+            submitted = arm_recv(fd, state);
+        }
+        else if(!want_recv && state.recv_armed && !state.recv_cancelled) {
+            state.recv_cancelled = cancel(make_tag(fd, state.recv_seq));
+            submitted = state.recv_cancelled;
+        }
+
+        const uint32_t wanted = added ? poll_events(ch, state.recv_mode || state.recv_armed, state.send_armed) : 0;
+
+        if(wanted == 0) {
+            if(state.armed_events) {
+                if(cancel(make_tag(fd, state.seq))) {
+                    state.armed_events = 0;
+                }
+                else {
+                    submitted = false;
+                }
+            }
+        }
+        else if(state.armed_events == 0) {
+            submitted = arm(fd, state, wanted, multishot) && submitted;
+        }
+        else if((wanted & ~state.armed_events) || multishot != state.multishot) {
+            if(cancel(make_tag(fd, state.seq))) {
+                state.armed_events = 0;
+                submitted = arm(fd, state, wanted, multishot) && submitted;
+            }
+            else {
+                submitted = false;
+            }
+        }
+        // MARK: 否则进行中的请求已覆盖所需的事件, 不必修改; 多余的事件在完成时过滤
+
+        if(!submitted) {
+            mark_dirty(fd, state);
+        }
+    }
+    _flushing.clear();
+}
+
+void IoUringPoller::reap(ChannelList *activeChannels)
+{
+    ++_round;
+
+    // 提交时因完成队列已满而移出的完成事件排在前面
+    for(const io_uring_cqe& cqe : _backlog) {
+        on_cqe(cqe, activeChannels);
+    }
+    _backlog.clear();
+
+    unsigned head = *_cq_head;
+    const unsigned tail = load_acquire(_cq_tail);
+
+    for(; head != tail; ++head) {
+        on_cqe(_cqes[head & _cq_mask], activeChannels);
+    }
+
+    store_release(_cq_head, head);
+
+    // 已经收到但还未取出的数据, 与LT相同, 每一轮都通知
+    collect_ready(activeChannels);
+}
+
+void IoUringPoller::on_cqe(const io_uring_cqe& cqe, ChannelList *activeChannels)
+{
+    if(cqe.user_data == kCancelTag) {
+        return;
+    }
+
+    const int fd = static_cast<int>(cqe.user_data >> 32);
+    const uint32_t seq = static_cast<uint32_t>(cqe.user_data);
+    const bool is_recv = seq & kRecvSeqBit;
+    const bool is_send = seq & kSendSeqBit;
+
+    // MARK: 发送的内存持有到请求的最后一个完成事件(零拷贝时为完成通知), 与Channel是否已移除无关
+    if(is_send && !(cqe.flags & IORING_CQE_F_MORE)) {
+        _sends.erase(cqe.user_data);
+    }
+    if(is_recv && !(cqe.flags & IORING_CQE_F_MORE)) {
+        --_recv_requests;
+    }
+    if(cqe.flags & IORING_CQE_F_NOTIF) {
+        return;
+    }
+
+    PollState* found = find_state(fd);
+    const uint32_t current = !found ? 0
+                           : is_recv ? found->recv_seq
+                           : is_send ? found->send_seq : found->seq;
+    if(!found || current != seq) {
+        // 已取消或已被替换的请求; 已经取出的缓冲区仍要归还
+        if(cqe.flags & IORING_CQE_F_BUFFER) {
+            --_recv_buffers_free;
+            recycle_buffer(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+        return;
+    }
+
+    PollState& state = *found;
+    Channel* ch = state.ch;
+
+    uint32_t revents = 0;
+    if(is_recv) {
+        on_recv_completion(fd, state, cqe);
+    }
+    else if(is_send) {
+        // 结果保存到取出为止; 之后按需重新监听写就绪事件
+        state.send_armed = false;
+        state.send_done = true;
+        state.send_result = cqe.res;
+        mark_dirty(fd, state);
+        revents = EPOLLOUT;
+    }
+    else {
+        // MARK: fd已经被关闭但Channel没有移除; epoll会自动忘记关闭的fd, 这里同样不再提交, 也不回调
+        if(cqe.res == -EBADF) {
+            state.armed_events = 0;
+            return;
+        }
+
+        // 请求已结束(单次poll, 或multishot被内核终止), 下一轮按当前的事件重新提交
+        if(!(cqe.flags & IORING_CQE_F_MORE)) {
+            state.armed_events = 0;
+            mark_dirty(fd, state);
+        }
+
+        if(!state.active) {
+            return;
+        }
+        if(cqe.res >= 0) {
+            const uint32_t wanted = poll_events(ch, state.recv_mode || state.recv_armed, state.send_armed);
+            revents = static_cast<uint32_t>(cqe.res) & (wanted | EPOLLERR | EPOLLHUP);
+        }
+        else if(cqe.res != -ECANCELED) {
+            revents = EPOLLERR;
+        }
+    }
+
+    if(revents == 0 || !state.active) {
+        return;
+    }
+
+    // multishot可能在一轮中对同一个Channel产生多个完成事件
+    if(state.round == _round) {
+        ch->set_happened_events(ch->get_happened_events() | revents);
+    }
+    else {
+        state.round = _round;
+        ch->set_happened_events(revents);
+        activeChannels->emplace_back(ch);
+    }
+}
+
+void IoUringPoller::on_recv_completion(int fd, PollState& state, const io_uring_cqe& cqe)
+{
+    if(!(cqe.flags & IORING_CQE_F_MORE)) {
+        state.recv_armed = false;
+        state.recv_cancelled = false;
+    }
+
+    if(cqe.res > 0 && (cqe.flags & IORING_CQE_F_BUFFER)) {
+        --_recv_buffers_free;
+        state.received.emplace_back(static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT),
+                                    static_cast<uint32_t>(cqe.res));
+    }
+    else if(cqe.res == 0) {
+        state.recv_eof = true;
+    }
+    else if(cqe.res == -ENOBUFS) {
+        // MARK: 缓冲区环暂时耗尽, 等其它连接取出数据归还缓冲区后再重新提交, 否则会立即再次失败
+        LOG_DEBUG("{} recv buffers exhausted at fd={}.", __FUNCTION__, fd);
+        if(state.recv_mode && _recv_buffers_free == 0) {
+            _starved.push_back(fd);
+            return;
+        }
+    }
+    else if(cqe.res < 0 && cqe.res != -ECANCELED) {
+        state.recv_error = -cqe.res;
+    }
+
+    if(!state.recv_armed) {
+        mark_dirty(fd, state);
+    }
+
+    if(has_received(state) && !state.ready) {
+        state.ready = true;
+        _ready.push_back(fd);
+    }
+}
+
+bool IoUringPoller::collect_ready(ChannelList *activeChannels)
+{
+    bool any = false;
+    std::erase_if(_ready, [&](int fd) {
+        PollState& state = _states[fd];
+        if(!state.ch || !has_received(state)) {
+            state.ready = false;
+            return true;
+        }
+
+        // 暂停读取时数据留在缓冲区中, 恢复读取后再通知
+        Channel* ch = state.ch;
+        if(!state.active || !(ch->get_monitored_events() & kReadEvents)) {
+            return false;
+        }
+
+        any = true;
+        if(activeChannels) {
+            if(state.round == _round) {
+                ch->set_happened_events(ch->get_happened_events() | EPOLLIN);
+            }
+            else {
+                state.round = _round;
+                ch->set_happened_events(EPOLLIN);
+                activeChannels->emplace_back(ch);
+            }
+        }
+        return false;
+    });
+    return any;
+}
+
+void IoUringPoller::update_channel(Channel *ch)
+{
+    channelStatus status = ch->get_status();
+    const int fd = ch->fd();
+
+    LOG_INFO("func:{} => fd={} events={} status={}", __FUNCTION__, fd, ch->get_monitored_events(), (int)status);
+
+    if(status == kNew || status == kDeleted) {
+        if(status == kNew) {
+            _channel_table.insert(ch);
+            prepare_state(ch).pending = false;
+        }
+        ch->set_status(kAdded);
+    }
+    else if(ch->is_none_events()) {
+        ch->set_status(kDeleted);
+    }
+
+    PollState& state = _states[fd];
+    state.active = ch->get_status() == kAdded;
+    mark_dirty(fd, state);
+}
+
+IoUringPoller::PollState& IoUringPoller::prepare_state(Channel *ch)
+{
+    const int fd = ch->fd();
+    if(static_cast<std::size_t>(fd) >= _states.size()) {
+        _states.resize(std::max(_channel_table.capacity(), static_cast<std::size_t>(fd) + 1));
+    }
+
+    // MARK: 还未加入的Channel只保留它自己在加入前设置的完成模式;
+    //       其余都是复用了同一个fd的旧Channel(没有调用remove_channel就被析构)残留的状态, 必须清除
+    PollState& state = _states[fd];
+    if(ch->get_status() == kNew && !(state.ch == ch && state.pending)) {
+        // 残留的请求不再需要; 之后它们的完成事件因序号不匹配而被丢弃, 取出的缓冲区照常归还
+        if(state.armed_events) {
+            cancel(make_tag(fd, state.seq));
+        }
+        if(state.recv_armed && !state.recv_cancelled) {
+            cancel(make_tag(fd, state.recv_seq));
+        }
+        reset_state(state);
+        state.ch = ch;
+        state.pending = true;
+    }
+    return state;
+}
+
+void IoUringPoller::reset_state(PollState& state)
+{
+    recycle_received(state);
+
+    // fd可能仍在 _dirty 与 _ready 中, 保留这两个标记, 处理列表时再清除
+    const bool dirty = state.dirty;
+    const bool ready = state.ready;
+    state = PollState {};
+    state.dirty = dirty;
+    state.ready = ready;
+}
+
+void IoUringPoller::remove_channel(Channel *ch)
+{
+    const int fd = ch->fd();
+
+    LOG_INFO("func:{} => fd={} events={} status={}", __FUNCTION__, fd, ch->get_monitored_events(), (int)ch->get_status());
+
+    // MARK: 进行中的poll请求持有文件的引用, 调用者随后close(fd)时文件不会真正关闭(如监听socket仍会接受连接),
+    //       所以取消请求要立即提交, 而不是等到下一轮poll
+    if(PollState* found = find_state(fd)) {
+        PollState& state = *found;
+        const bool cancel_poll = state.armed_events != 0;
+        const bool cancel_recv = state.recv_armed && !state.recv_cancelled;
+        if(cancel_poll) {
+            cancel(make_tag(fd, state.seq));
+        }
+        if(cancel_recv) {
+            cancel(make_tag(fd, state.recv_seq));
+        }
+        // 等待socket可写的发送请求同样持有文件; 已经交给协议栈的数据不受影响, 内存由_sends持有
+        if(state.send_armed) {
+            cancel(make_tag(fd, state.send_seq));
+        }
+        if(cancel_poll || cancel_recv || state.send_armed) {
+            enter(false, false, std::chrono::system_clock::duration::zero());
+        }
+        reset_state(state);
+    }
+
+    _channel_table.erase(fd);
+    ch->set_status(kNew);
+}
+
+bool IoUringPoller::probe_completion_ops()
+{
+    if(_completion_ops >= 0) {
+        return _completion_ops;
+    }
+    if(!valid()) {
+        return false;
+    }
+
+    // MARK: multishot recv与 IORING_OP_SEND_ZC 在同一个内核版本(6.0)中引入, 没有直接的探测手段, 以后者代替
+    constexpr unsigned kProbeOps = IORING_OP_SENDMSG_ZC + 1;
+    alignas(io_uring_probe) char probe_buf[sizeof(io_uring_probe) + kProbeOps * sizeof(io_uring_probe_op)] = {};
+    auto* probe = reinterpret_cast<io_uring_probe*>(probe_buf);
+    const bool probed = ::syscall(SYS_io_uring_register, _ring_fd, IORING_REGISTER_PROBE, probe, kProbeOps) == 0;
+    auto supported = [&](unsigned op) {
+        return probed && probe->last_op >= op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    };
+    _completion_ops = supported(IORING_OP_SEND_ZC);
+    _sendmsg_zero_copy = supported(IORING_OP_SENDMSG_ZC);
+
+    if(!_completion_ops) {
+        LOG_WARN("io_uring does not support multishot recv and zero copy send.");
+    }
+    return _completion_ops;
+}
+
+bool IoUringPoller::setup_recv_pool()
+{
+    if(_recv_pool) {
+        return true;
+    }
+    if(_recv_pool_failed || !probe_completion_ops()) {
+        return false;
+    }
+    _recv_pool_failed = true;
+
+    // 缓冲区环须按页对齐, 由内核与用户态共享; 缓冲区的内存在第一次被内核写入时才真正分配
+    void* ring = ::mmap(nullptr, kRecvBuffers * sizeof(io_uring_buf), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(ring == MAP_FAILED) {
+        LOG_WARN("mmap recv buffer ring failed, errno = {} {}.", errno, strerror(errno));
+        return false;
+    }
+
+    void* pool = ::mmap(nullptr, kRecvBuffers * kRecvBufferSize, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(pool == MAP_FAILED) {
+        LOG_WARN("mmap recv buffers failed, errno = {} {}.", errno, strerror(errno));
+        ::munmap(ring, kRecvBuffers * sizeof(io_uring_buf));
+        return false;
+    }
+
+    io_uring_buf_reg reg;
+    std::memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+    reg.ring_entries = kRecvBuffers;
+    reg.bgid = kRecvGroup;
+    if(::syscall(SYS_io_uring_register, _ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        LOG_WARN("io_uring register buffer ring failed, errno = {} {}.", errno, strerror(errno));
+        ::munmap(pool, kRecvBuffers * kRecvBufferSize);
+        ::munmap(ring, kRecvBuffers * sizeof(io_uring_buf));
+        return false;
+    }
+
+    _buf_ring = static_cast<io_uring_buf_ring*>(ring);
+    _recv_pool = static_cast<char*>(pool);
+    _recv_pool_failed = false;
+
+    // 所有缓冲区一开始都交给内核
+    _buf_ring_tail = 0;
+    for(unsigned bid = 0; bid < kRecvBuffers; ++bid) {
+        recycle_buffer(static_cast<uint16_t>(bid));
+    }
+    flush_recycled();
+    return true;
+}
+
+void IoUringPoller::recycle_buffer(uint16_t bid)
+{
+    // MARK: 第0项的resv字段与环的尾部重叠, 只能写入addr, len与bid
+    // C++中柔性数组bufs前的空结构体占用了空间, 直接取bufs会错位, 从环的起始地址按io_uring_buf寻址
+    io_uring_buf& buf = reinterpret_cast<io_uring_buf*>(_buf_ring)[_buf_ring_tail & (kRecvBuffers - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(buffer_addr(bid));
+    buf.len = static_cast<uint32_t>(kRecvBufferSize);
+    buf.bid = bid;
+    ++_buf_ring_tail;
+    ++_recv_buffers_free;
+
+    // 缓冲区耗尽时停下的recv请求可以重新提交了
+    if(!_starved.empty()) {
+        for(int fd : _starved) {
+            if(PollState* state = find_state(fd)) {
+                mark_dirty(fd, *state);
+            }
+        }
+        _starved.clear();
+    }
+}
+
+void IoUringPoller::flush_recycled()
+{
+    // 一次推进尾部即可归还本轮所有的缓冲区
+    if(_buf_ring && _buf_ring->tail != _buf_ring_tail) {
+        store_release(&_buf_ring->tail, _buf_ring_tail);
+    }
+}
+
+void IoUringPoller::recycle_received(PollState& state)
+{
+    for(const auto& [bid, len] : state.received) {
+        recycle_buffer(bid);
+    }
+    state.received.clear();
+}
+
+bool IoUringPoller::arm_recv(int fd, PollState& state)
+{
+    io_uring_sqe* sqe = get_sqe();
+    if(!sqe) {
+        return false;
+    }
+
+    state.recv_seq = next_seq() | kRecvSeqBit;
+    state.recv_armed = true;
+    ++_recv_requests;
+    state.recv_cancelled = false;
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kRecvGroup;
+    sqe->user_data = make_tag(fd, state.recv_seq);
+    return true;
+}
+
+bool IoUringPoller::set_completion_recv(Channel *ch, bool on)
+{
+    if(on && !setup_recv_pool()) {
+        return false;
+    }
+
+    const int fd = ch->fd();
+    PollState& state = prepare_state(ch);
+    if(state.recv_mode == on) {
+        return true;
+    }
+
+    // MARK: 关闭时不丢弃已收到的数据, recv请求在下一轮取消, 内核确认之前的完成事件仍然有效
+    state.recv_mode = on;
+
+    // 读事件在poll请求与recv请求之间迁移
+    if(ch->get_status() != kNew) {
+        mark_dirty(fd, state);
+    }
+    return true;
+}
+
+bool IoUringPoller::recv_pending(Channel *ch) const
+{
+    const PollState* state = find_state(ch->fd());
+    return state && state->recv_armed;
+}
+
+ssize_t IoUringPoller::take_received(Channel *ch, Buffer *buf)
+{
+    PollState* found = find_state(ch->fd());
+    if(!found) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    PollState& state = *found;
+    if(!state.received.empty()) {
+        ssize_t total = 0;
+        for(const auto& [bid, len] : state.received) {
+            buf->append(buffer_addr(bid), len);
+            total += len;
+        }
+        recycle_received(state);
+        return total;
+    }
+
+    if(state.recv_eof) {
+        return 0;
+    }
+    if(state.recv_error != 0) {
+        errno = state.recv_error;
+        return -1;
+    }
+
+    errno = EAGAIN;
+    return -1;
+}
+
+bool IoUringPoller::set_completion_send(Channel *ch, bool on)
+{
+    if(on && !probe_completion_ops()) {
+        return false;
+    }
+
+    // MARK: 关闭时进行中的发送请求照常完成, 结果仍由 take_sent 取出
+    PollState& state = prepare_state(ch);
+    state.send_mode = on;
+    return true;
+}
+
+bool IoUringPoller::submit_send(Channel *ch, const struct iovec *iov, int iov_count, bool zero_copy,
+                                std::shared_ptr<const void> holder)
+{
+    const int fd = ch->fd();
+    PollState* found = find_state(fd);
+    if(!found || !found->send_mode || found->send_armed || found->send_done || iov_count <= 0) {
+        return false;
+    }
+
+    io_uring_sqe* sqe = get_sqe();
+    if(!sqe) {
+        return false;
+    }
+
+    PollState& state = *found;
+    state.send_seq = next_seq() | kSendSeqBit;
+    state.send_armed = true;
+
+    const uint64_t tag = make_tag(fd, state.send_seq);
+    SendRequest& request = _sends[tag];
+    request.holder = std::move(holder);
+
+    sqe->fd = fd;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = tag;
+
+    if(iov_count == 1) {
+        sqe->opcode = zero_copy ? IORING_OP_SEND_ZC : IORING_OP_SEND;
+        sqe->addr = reinterpret_cast<uint64_t>(iov[0].iov_base);
+        sqe->len = static_cast<uint32_t>(iov[0].iov_len);
+    }
+    else {
+        // MARK: 内核可能在提交之后才读取msghdr与iovec(请求被挂起等待socket可写时), 副本保存到请求的最后一个完成事件
+        zero_copy = zero_copy && _sendmsg_zero_copy;
+        request.iov.assign(iov, iov + iov_count);
+        request.msg.msg_iov = request.iov.data();
+        request.msg.msg_iovlen = request.iov.size();
+
+        sqe->opcode = zero_copy ? IORING_OP_SENDMSG_ZC : IORING_OP_SENDMSG;
+        sqe->addr = reinterpret_cast<uint64_t>(&request.msg);
+        sqe->len = 1;
+    }
+
+    ++_send_requests;
+    if(zero_copy) {
+        ++_zero_copy_requests;
+    }
+
+    // 写事件改由发送请求通知, 不再监听写就绪事件
+    mark_dirty(fd, state);
+    return true;
+}
+
+ssize_t IoUringPoller::take_sent(Channel *ch)
+{
+    PollState* found = find_state(ch->fd());
+    if(!found || !found->send_done) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    PollState& state = *found;
+    state.send_done = false;
+    if(state.send_result < 0) {
+        errno = -state.send_result;
+        return -1;
+    }
+    return state.send_result;
+}
@@ -0,0 +1,133 @@
+#include "mymuduo/base/Logger.h"
+#include "mymuduo/net/Channel.h"
+#include "mymuduo/net/poller/PollPoller.h"
+
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sys/epoll.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+PollPoller::PollPoller(EventLoop *loop) : Poller(loop)
+{
+}
+
+Timestamp PollPoller::poll(ChannelList *activeChannels, std::chrono::system_clock::duration timeout)
+{
+    using namespace std::chrono;
+
+    LOG_DEBUG("func:{} => fd total count={}", __FUNCTION__, _pollfds.size());
+
+    Timestamp now = Timestamp::now();
+    int numEvents = ::poll(_pollfds.data(), _pollfds.size()
+                        , timeout == system_clock::duration::max()
+                                    ? -1 : duration_cast<milliseconds>(timeout).count());
+    int savedErrno = errno;
+
+    if(numEvents > 0) {
+        LOG_DEBUG("{} events happened.", numEvents);
+        fill_active_channels(numEvents, activeChannels);
+    }
+    else if(numEvents < 0) {
+        if(savedErrno != EINTR) {
+            errno = savedErrno;
+            LOG_ERROR("{}:{}:{} - errno = {} {}.",
+                __FILE__, __FUNCTION__, __LINE__, errno, strerror(errno));
+        }
+    }
+    else {
+        LOG_DEBUG("{} timeout!", __FUNCTION__);
+    }
+
+    return now;
+}
+
+void PollPoller::fill_active_channels(int numEvents, ChannelList *activeChannels) const
+{
+    // 找到numEvents个发生事件的fd后即可停止
+    for(std::size_t i = 0; i < _pollfds.size() && numEvents > 0; ++i) {
+        const pollfd& pfd = _pollfds[i];
+        if(pfd.revents > 0) {
+            --numEvents;
+
+            // POLLNVAL: fd已被关闭但Channel没有移除, 与epoll一样忽略
+            if(pfd.revents & POLLNVAL) {
+                continue;
+            }
+
+            Channel* ch = _channels[i];
+            ch->set_happened_events(static_cast<unsigned short>(pfd.revents));
+            activeChannels->emplace_back(ch);
+        }
+    }
+}
+
+short PollPoller::to_poll_events(Channel *ch)
+{
+    // MARK: EPOLLIN/EPOLLPRI/EPOLLOUT/EPOLLRDHUP 与 poll 的对应事件取值相同, 只需去掉EPOLLET
+    return static_cast<short>(ch->get_monitored_events() & ~static_cast<uint32_t>(EPOLLET));
+}
+
+void PollPoller::update_channel(Channel *ch)
+{
+    channelStatus status = ch->get_status();
+
+    LOG_INFO("func:{} => fd={} events={} status={}", __FUNCTION__, ch->fd(), ch->get_monitored_events(), (int)status);
+
+    if(status == kNew) {
+        assert(ch->index() < 0);
+        _channel_table.insert(ch);
+
+        ch->set_index(static_cast<int>(_pollfds.size()));
+        _pollfds.push_back(pollfd { ch->fd(), to_poll_events(ch), 0 });
+        _channels.push_back(ch);
+        ch->set_status(kAdded);
+        return;
+    }
+
+    const int idx = ch->index();
+    assert(idx >= 0 && idx < static_cast<int>(_pollfds.size()));
+    assert(_channels[idx] == ch);
+
+    pollfd& pfd = _pollfds[idx];
+    pfd.events = to_poll_events(ch);
+    pfd.revents = 0;
+
+    // MARK: 不监听任何事件时保留位置, 将fd取反让poll忽略该项(-fd-1, 兼容fd为0的情况)
+    if(ch->is_none_events()) {
+        pfd.fd = -ch->fd() - 1;
+        ch->set_status(kDeleted);
+    }
+    else {
+        pfd.fd = ch->fd();
+        ch->set_status(kAdded);
+    }
+}
+
+void PollPoller::remove_channel(Channel *ch)
+{
+    LOG_INFO("func:{} => fd={} events={} status={}", __FUNCTION__, ch->fd(), ch->get_monitored_events(), (int)ch->get_status());
+
+    const int idx = ch->index();
+    if(idx >= 0) {
+        assert(idx < static_cast<int>(_pollfds.size()));
+        assert(_channels[idx] == ch);
+
+        // 与末尾交换后删除, 被移动的Channel更新下标
+        const int last = static_cast<int>(_pollfds.size()) - 1;
+        if(idx != last) {
+            _pollfds[idx] = _pollfds[last];
+            _channels[idx] = _channels[last];
+            _channels[idx]->set_index(idx);
+        }
+        _pollfds.pop_back();
+        _channels.pop_back();
+    }
+
+    _channel_table.erase(ch->fd());
+    ch->set_index(-1);
+    ch->set_status(kNew);
+}
@@ -0,0 +1,137 @@
+#include "mymuduo/base/CpuTopology.h"
+#include "mymuduo/net/EventLoopThreadPool.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// 在临时目录中构造一个假的sysfs: 2个NUMA节点, 每个节点2个物理核, 每个核2个超线程
+class CpuTopologyTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        _root = fs::temp_directory_path() / ("mymuduo_sysfs_" + std::to_string(::getpid()));
+        fs::remove_all(_root);
+
+        write("cpu/online", "0-7");
+        write("cpu/isolated", "7");
+        write("node/node0/cpulist", "0-1,4-5");
+        write("node/node1/cpulist", "2-3,6-7");
+
+        // cpu i 与 cpu i+4 是同一个物理核的两个超线程
+        for(int cpu = 0; cpu < 8; ++cpu) {
+            const std::string dir = "cpu/cpu" + std::to_string(cpu) + "/topology/";
+            write(dir + "core_id", std::to_string(cpu % 2));
+            write(dir + "physical_package_id", std::to_string((cpu % 4) / 2));
+        }
+    }
+
+    void TearDown() override {
+        fs::remove_all(_root);
+    }
+
+    void write(const std::string& path, const std::string& content) {
+        fs::path file = _root / path;
+        fs::create_directories(file.parent_path());
+        std::ofstream(file) << content << "\n";
+    }
+
+protected:
+    fs::path _root;
+};
+
+
+// TAG: 解析CPU列表
+TEST(CpuListTest, Parse) {
+    EXPECT_EQ(CpuTopology::parse_cpu_list(""), std::vector<int>{});
+    EXPECT_EQ(CpuTopology::parse_cpu_list("3"), std::vector<int>{ 3 });
+    EXPECT_EQ(CpuTopology::parse_cpu_list("0-3,8,10-11"), (std::vector<int>{ 0, 1, 2, 3, 8, 10, 11 }));
+    EXPECT_EQ(CpuTopology::parse_cpu_list("2,0-2"), (std::vector<int>{ 0, 1, 2 }));
+}
+
+
+// TAG: 读取拓扑, 跳过隔离的CPU, 按节点和物理核排序
+TEST_F(CpuTopologyTest, FromSysfs) {
+    CpuTopology topo = CpuTopology::from_sysfs(_root.string());
+
+    ASSERT_EQ(topo.cpus().size(), 7);
+    EXPECT_EQ(topo.num_nodes(), 2);
+
+    std::vector<int> order;
+    for(const CpuTopology::Cpu& cpu : topo.cpus()) {
+        order.push_back(cpu.id);
+    }
+    EXPECT_EQ(order, (std::vector<int>{ 0, 4, 1, 5, 2, 6, 3 }));
+
+    EXPECT_EQ(topo.cpus()[0].node, 0);
+    EXPECT_EQ(topo.cpus()[4].node, 1);
+    EXPECT_EQ(topo.cpus()[4].package, 1);
+}
+
+
+// TAG: 没有node目录时所有CPU都属于节点0
+TEST_F(CpuTopologyTest, NoNumaNodes) {
+    fs::remove_all(_root / "node");
+    CpuTopology topo = CpuTopology::from_sysfs(_root.string());
+    EXPECT_EQ(topo.num_nodes(), 1);
+    EXPECT_EQ(topo.cpus().size(), 7);
+}
+
+
+// TAG: 按策略为loop分配CPU
+TEST_F(CpuTopologyTest, PlanPlacement) {
+    CpuTopology topo = CpuTopology::from_sysfs(_root.string());
+
+    EXPECT_TRUE(EventLoopThreadPool::plan_placement(topo, PlacementPolicy::kNone, 4).empty());
+
+    // 每个物理核一个loop, 在节点间轮流分配, 超过核数后循环复用
+    auto per_core = EventLoopThreadPool::plan_placement(topo, PlacementPolicy::kPerCore, 5);
+    ASSERT_EQ(per_core.size(), 5);
+    EXPECT_EQ(per_core[0].cpus, (std::vector<int>{ 0, 4 }));
+    EXPECT_EQ(per_core[0].node, 0);
+    EXPECT_EQ(per_core[1].cpus, (std::vector<int>{ 2, 6 }));
+    EXPECT_EQ(per_core[1].node, 1);
+    EXPECT_EQ(per_core[2].cpus, (std::vector<int>{ 1, 5 }));
+    EXPECT_EQ(per_core[3].cpus, (std::vector<int>{ 3 }));
+    EXPECT_EQ(per_core[4].cpus, per_core[0].cpus);
+
+    auto per_node = EventLoopThreadPool::plan_placement(topo, PlacementPolicy::kPerNode, 3);
+    ASSERT_EQ(per_node.size(), 3);
+    EXPECT_EQ(per_node[0].cpus, (std::vector<int>{ 0, 4, 1, 5 }));
+    EXPECT_EQ(per_node[1].cpus, (std::vector<int>{ 2, 6, 3 }));
+    EXPECT_EQ(per_node[2].node, 0);
+}
+
+
+// TAG: 本机拓扑与绑核
+TEST(CpuTopologyDetectTest, DetectAndPin) {
+    CpuTopology topo = CpuTopology::detect();
+    ASSERT_FALSE(topo.empty());
+
+    const int cpu = topo.cpus().front().id;
+    std::thread t([cpu] {
+        ASSERT_TRUE(CpuTopology::pin_current_thread({ cpu }));
+        EXPECT_EQ(::sched_getcpu(), cpu);
+    });
+    t.join();
+
+    EXPECT_FALSE(CpuTopology::pin_current_thread({}));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
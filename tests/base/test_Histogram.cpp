@@ -0,0 +1,94 @@
+#include "mymuduo/base/Histogram.h"
+
+#include <cstdint>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace mymuduo;
+
+namespace {
+
+
+// TAG: 对数分桶
+TEST(HistogramTest, BucketIndex) {
+    EXPECT_EQ(Histogram::bucket_index(0), 0);
+    EXPECT_EQ(Histogram::bucket_index(1), 1);
+    EXPECT_EQ(Histogram::bucket_index(2), 2);
+    EXPECT_EQ(Histogram::bucket_index(3), 2);
+    EXPECT_EQ(Histogram::bucket_index(1024), 11);
+    EXPECT_EQ(Histogram::bucket_index(UINT64_MAX), Histogram::kBuckets - 1);
+
+    EXPECT_EQ(Histogram::bucket_upper(0), 0);
+    EXPECT_EQ(Histogram::bucket_upper(2), 3);
+    EXPECT_EQ(Histogram::bucket_upper(11), 2047);
+}
+
+
+// TAG: 计数, 均值与分位数
+TEST(HistogramTest, RecordAndPercentile) {
+    Histogram h;
+    EXPECT_EQ(h.snapshot().percentile(0.5), 0);
+
+    for(uint64_t v = 1; v <= 1000; ++v) {
+        h.record(v);
+    }
+
+    Histogram::Snapshot s = h.snapshot();
+    EXPECT_EQ(s.count, 1000);
+    EXPECT_EQ(s.sum, 500500);
+    EXPECT_EQ(s.max, 1000);
+    EXPECT_DOUBLE_EQ(s.mean(), 500.5);
+
+    // 分位数的误差在2倍以内
+    EXPECT_GE(s.percentile(0.5), 500);
+    EXPECT_LT(s.percentile(0.5), 1000);
+    EXPECT_EQ(s.percentile(0.99), 1000);
+    EXPECT_EQ(s.percentile(1.0), 1000);
+}
+
+
+// TAG: 合并快照
+TEST(HistogramTest, Merge) {
+    Histogram a, b;
+    a.record(1);
+    a.record(100);
+    b.record(5000);
+
+    Histogram::Snapshot s = a.snapshot();
+    s.merge(b.snapshot());
+    EXPECT_EQ(s.count, 3);
+    EXPECT_EQ(s.sum, 5101);
+    EXPECT_EQ(s.max, 5000);
+    EXPECT_EQ(s.buckets[Histogram::bucket_index(100)], 1);
+}
+
+
+// TAG: 一个线程写入时其它线程读取快照
+TEST(HistogramTest, ConcurrentSnapshot) {
+    Histogram h;
+    constexpr uint64_t kRecords = 100000;
+
+    std::thread writer([&] {
+        for(uint64_t i = 0; i < kRecords; ++i) {
+            h.record(i & 0xff);
+        }
+    });
+
+    uint64_t last = 0;
+    while(last < kRecords) {
+        uint64_t count = h.snapshot().count;
+        ASSERT_GE(count, last);
+        last = count;
+    }
+    writer.join();
+
+    EXPECT_EQ(h.snapshot().count, kRecords);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
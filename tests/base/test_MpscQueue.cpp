@@ -0,0 +1,144 @@
+#include "mymuduo/base/MpscQueue.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace mymuduo;
+
+namespace {
+
+
+// TAG: 单线程下先进先出
+TEST(MpscQueueTest, FifoOrder) {
+    MpscQueue<int> queue;
+    EXPECT_TRUE(queue.empty());
+
+    int value = 0;
+    EXPECT_FALSE(queue.pop(value));
+
+    for(int i = 0; i < 100; ++i) {
+        queue.push(i);
+    }
+    EXPECT_EQ(queue.size(), 100);
+
+    for(int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(queue.pop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_TRUE(queue.empty());
+}
+
+
+// TAG: 只能移动的元素, 出队后节点中不再持有对象
+TEST(MpscQueueTest, MoveOnly) {
+    MpscQueue<std::unique_ptr<int>> queue;
+    auto shared = std::make_shared<int>(0);
+
+    queue.push(std::make_unique<int>(7));
+    std::unique_ptr<int> value;
+    ASSERT_TRUE(queue.pop(value));
+    EXPECT_EQ(*value, 7);
+
+    // 出队时值被取出, 回收的节点不会延长其生命周期
+    MpscQueue<std::shared_ptr<int>> holders;
+    holders.push(shared);
+    std::shared_ptr<int> out;
+    ASSERT_TRUE(holders.pop(out));
+    out.reset();
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+
+// TAG: 析构时释放未取出的元素
+TEST(MpscQueueTest, DestroyWithPendingValues) {
+    auto shared = std::make_shared<int>(0);
+    {
+        MpscQueue<std::shared_ptr<int>> queue;
+        queue.push(shared);
+        queue.push(shared);
+        EXPECT_EQ(shared.use_count(), 3);
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+
+// TAG: 回收的节点只在本队列中复用, 生产者向其它队列入队时不会取走它们
+TEST(MpscQueueTest, FreeNodesStayWithQueue) {
+    MpscQueue<int> a;
+    MpscQueue<int> b;
+
+    int value = 0;
+    for(int i = 0; i < 10; ++i) {
+        a.push(i);
+    }
+    for(int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(a.pop(value));
+    }
+    EXPECT_EQ(a.free_nodes(), 10);
+
+    a.push(0);
+    EXPECT_EQ(a.free_nodes(), 9);
+
+    for(int i = 0; i < 5; ++i) {
+        b.push(i);
+    }
+    EXPECT_EQ(a.free_nodes(), 9);
+    EXPECT_EQ(b.free_nodes(), 0);
+
+    for(int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(b.pop(value));
+    }
+    EXPECT_EQ(b.free_nodes(), 5);
+}
+
+
+// TAG: 多个生产者并发入队, 每个元素恰好取出一次且同一生产者的元素保持顺序
+TEST(MpscQueueTest, MultipleProducers) {
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 100000;
+
+    MpscQueue<std::pair<int, int>> queue;
+    std::atomic<bool> start { false };
+
+    std::vector<std::thread> producers;
+    for(int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&, p] {
+            while(!start) { }
+            for(int i = 0; i < kPerProducer; ++i) {
+                queue.push({ p, i });
+            }
+        });
+    }
+
+    start = true;
+
+    std::vector<int> next(kProducers, 0);
+    int received = 0;
+    std::pair<int, int> value;
+    while(received < kProducers * kPerProducer) {
+        if(!queue.pop(value)) {
+            continue;
+        }
+        ASSERT_EQ(value.second, next[value.first]);
+        ++next[value.first];
+        ++received;
+    }
+
+    for(auto& t : producers) {
+        t.join();
+    }
+    EXPECT_FALSE(queue.pop(value));
+    EXPECT_TRUE(queue.empty());
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
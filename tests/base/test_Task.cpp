@@ -0,0 +1,108 @@
+#include "mymuduo/base/Task.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+using namespace mymuduo;
+
+namespace {
+
+// 记录析构次数, 检查被包装的对象恰好被析构一次
+struct Counted {
+    explicit Counted(int* destroyed) : destroyed(destroyed) { }
+    Counted(Counted&& other) noexcept : destroyed(std::exchange(other.destroyed, nullptr)) { }
+    ~Counted() { if(destroyed) ++*destroyed; }
+
+    int* destroyed;
+};
+
+
+// TAG: 空任务
+TEST(TaskTest, Empty) {
+    Task task;
+    EXPECT_FALSE(task);
+    EXPECT_FALSE(task.is_inline());
+
+    Task null_task(nullptr);
+    EXPECT_FALSE(null_task);
+}
+
+
+// TAG: 小对象存放在内联存储中, 超过内联大小的对象放在堆上
+TEST(TaskTest, InlineAndHeap) {
+    int calls = 0;
+
+    // 与跨线程 send 的捕获相同: shared_ptr + std::string
+    auto owner = std::make_shared<int>(1);
+    Task small([owner, msg = std::string("hello"), &calls] { calls += static_cast<int>(msg.size()); });
+    ASSERT_TRUE(small);
+    EXPECT_TRUE(small.is_inline());
+
+    std::array<char, Task::kInlineSize + 1> big_data { };
+    Task big([big_data, &calls] { calls += static_cast<int>(big_data.size()); });
+    ASSERT_TRUE(big);
+    EXPECT_FALSE(big.is_inline());
+
+    small();
+    big();
+    EXPECT_EQ(calls, 5 + static_cast<int>(Task::kInlineSize + 1));
+}
+
+
+// TAG: 可以捕获只能移动的对象
+TEST(TaskTest, MoveOnlyCapture) {
+    int value = 0;
+    auto ptr = std::make_unique<int>(42);
+
+    Task task([ptr = std::move(ptr), &value] { value = *ptr; });
+    task();
+    EXPECT_EQ(value, 42);
+}
+
+
+// TAG: 移动后源对象为空, 被包装的对象只会析构一次
+TEST(TaskTest, MoveAndDestroy) {
+    int destroyed = 0;
+    int calls = 0;
+
+    {
+        Task a([c = Counted(&destroyed), &calls] { ++calls; });
+        EXPECT_TRUE(a.is_inline());
+
+        Task b(std::move(a));
+        EXPECT_FALSE(a);
+        ASSERT_TRUE(b);
+        b();
+
+        Task c;
+        c = std::move(b);
+        EXPECT_FALSE(b);
+        c();
+        EXPECT_EQ(destroyed, 0);
+    }
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(destroyed, 1);
+
+    // 堆上的对象同样只析构一次, 赋值为nullptr时立即释放
+    destroyed = 0;
+    std::array<char, Task::kInlineSize> padding { };
+    Task heap([c = Counted(&destroyed), padding] { });
+    EXPECT_FALSE(heap.is_inline());
+
+    Task moved(std::move(heap));
+    EXPECT_EQ(destroyed, 0);
+    moved = nullptr;
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(destroyed, 1);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
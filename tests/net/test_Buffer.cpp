@@ -77,6 +77,142 @@ TEST(BufferTest, SeparationStrategies) {
 }
 
 
+// TAG: 分割符后缀的报文分多次到达
+TEST(BufferTest, DelimiterArrivesIncrementally) {
+    Buffer buf;
+    buf.set_sep(Buffer::DelimiterSuffix);
+
+    std::string body(3000, 'x');
+    for(std::size_t i = 0; i < body.size(); ++i) {
+        body[i] = static_cast<char>('a' + i % 26);
+    }
+    const std::string frame = body + "\r\n\r\n" + "next";
+
+    // 逐字节追加, 分割符会被拆散在多次到达的数据中
+    std::string result;
+    std::size_t i = 0;
+    for(; i < body.size() + 3; ++i) {
+        buf.append(frame.data() + i, 1);
+        EXPECT_FALSE(buf.pick_datagram(result));
+    }
+    buf.append(frame.data() + i, frame.size() - i);
+
+    EXPECT_TRUE(buf.pick_datagram(result));
+    EXPECT_EQ(result, body);
+    EXPECT_EQ(buf.readable(), 4);
+    EXPECT_FALSE(buf.pick_datagram(result));
+
+    // 断点不会跳过后续报文中的分割符
+    buf.append("\r\n\r\n", 4);
+    EXPECT_TRUE(buf.pick_datagram(result));
+    EXPECT_EQ(result, "next");
+}
+
+
+// TAG: 同一个缓冲区交替使用不同的分割符, 扫描断点不会跨分割符生效
+TEST(BufferTest, SearchMixedDelimiters) {
+    Buffer buf;
+    buf.append("a\r\nbcdefg");
+
+    EXPECT_EQ(buf.search("\r\n\r\n"), std::string_view::npos);
+    EXPECT_EQ(buf.search("\r\n"), 1);
+    EXPECT_EQ(buf.search("\r\n\r\n"), std::string_view::npos);
+
+    buf.append("\r\n\r\n");
+    EXPECT_EQ(buf.search("\r\n\r\n"), 9);
+    EXPECT_EQ(buf.search("fg"), 7);
+    EXPECT_EQ(buf.search("\r\n"), 1);
+}
+
+
+// TAG: 以视图的方式取出报文
+TEST(BufferTest, PickDatagramView) {
+    Buffer buf;
+    buf.set_sep(Buffer::LengthPrefix);
+    buf.append_with_sep("ViewTest1");
+    buf.append_with_sep("ViewTest2");
+
+    // 报文头不完整
+    Buffer partial;
+    partial.set_sep(Buffer::LengthPrefix);
+    partial.append("\x05\x00", 2);
+    std::string_view view;
+    EXPECT_FALSE(partial.pick_datagram(view));
+
+    // 视图直接指向缓冲区内部, 不发生拷贝
+    const char* data = buf.cbegin() + buf.prependable();
+    EXPECT_TRUE(buf.pick_datagram(view));
+    EXPECT_EQ(view, "ViewTest1");
+    EXPECT_EQ(view.data(), data + 4);
+
+    EXPECT_TRUE(buf.pick_datagram(view));
+    EXPECT_EQ(view, "ViewTest2");
+    EXPECT_EQ(buf.readable(), 0);
+    EXPECT_FALSE(buf.pick_datagram(view));
+}
+
+
+// TAG: 批量取出所有完整报文
+TEST(BufferTest, ForEachDatagram) {
+    Buffer buf;
+    buf.set_sep(Buffer::DelimiterSuffix);
+    buf.append_with_sep("frame1");
+    buf.append_with_sep("frame2");
+    buf.append_with_sep("frame3");
+    buf.append("partial", 7);
+
+    std::vector<std::string> frames;
+    std::size_t count = buf.for_each_datagram([&](std::string_view msg) {
+        frames.emplace_back(msg);
+    });
+
+    EXPECT_EQ(count, 3);
+    ASSERT_EQ(frames.size(), 3);
+    EXPECT_EQ(frames[0], "frame1");
+    EXPECT_EQ(frames[1], "frame2");
+    EXPECT_EQ(frames[2], "frame3");
+
+    // 不完整的报文留在缓冲区中
+    EXPECT_EQ(buf.readable(), 7);
+    buf.append("\r\n\r\n", 4);
+    EXPECT_EQ(buf.for_each_datagram([&](std::string_view msg) {
+        EXPECT_EQ(msg, "partial");
+    }), 1);
+}
+
+
+// TAG: 报文头原地写入prependable区域
+TEST(BufferTest, Prepend) {
+    Buffer buf;
+    ASSERT_EQ(buf.prependable(), 8);
+
+    buf.append("payload");
+    const char* body = buf.peek();
+
+    buf.prepend_int32(7);
+    EXPECT_EQ(buf.prependable(), 4);
+    EXPECT_EQ(buf.readable(), 11);
+
+    // 报文内容没有被移动
+    EXPECT_EQ(buf.peek() + 4, body);
+    EXPECT_EQ(std::string(buf.peek(), 4), std::string("\0\0\0\x07", 4));
+
+    buf.prepend_int16(0x0102);
+    EXPECT_EQ(std::string(buf.peek(), 2), "\x01\x02");
+
+    // 与 pick_datagram 的报文头格式一致
+    Buffer framed;
+    framed.set_sep(Buffer::LengthPrefix);
+    framed.append("hello");
+    int32_t len = 5;
+    framed.prepend(&len, sizeof len);
+
+    std::string msg;
+    EXPECT_TRUE(framed.pick_datagram(msg));
+    EXPECT_EQ(msg, "hello");
+}
+
+
 // TAG: 缓冲区大小管理测试
 TEST(BufferTest, BufferSizeManagement) {
     // 测试自定义初始大小
@@ -153,6 +289,30 @@ TEST(BufferTest, FileDescriptorOperations) {
 }
 
 
+// TAG: 溢出到外部临时缓冲区的数据原样追加
+TEST(BufferTest, ReadFdSpillToScratch) {
+    int pipefd[2];
+    ASSERT_EQ(pipe(pipefd), 0);
+
+    const std::string data(100, 'S');
+    ASSERT_EQ(::write(pipefd[1], data.data(), data.size()), data.size());
+
+    // 接收路径即使设置了分割符, 也不能给溢出的数据添加报文头
+    Buffer buf(8, 16);
+    buf.set_sep(Buffer::LengthPrefix);
+
+    char scratch[256];
+    int err = 0;
+    size_t readSize = buf.read_fd(pipefd[0], &err, scratch, sizeof(scratch));
+    EXPECT_EQ(readSize, data.size());
+    EXPECT_EQ(buf.readable(), data.size());
+    EXPECT_EQ(buf.retrieve_all_as_string(), data);
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+
 // TAG: 边界条件测试
 TEST(BufferTest, BoundaryConditions) {
     // 测试空缓冲区操作
@@ -0,0 +1,143 @@
+#include "mymuduo/base/CurrentThread.h"
+#include "mymuduo/net/Buffer.h"
+#include "mymuduo/net/BufferPool.h"
+#include "mymuduo/net/ChainBuffer.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+namespace {
+
+// TAG: 级别划分
+TEST(BufferPoolTest, BlockSize) {
+    EXPECT_EQ(BufferPool::block_size(1), BufferPool::kMinBlockSize);
+    EXPECT_EQ(BufferPool::block_size(1024), 1024);
+    EXPECT_EQ(BufferPool::block_size(1025), 2048);
+    EXPECT_EQ(BufferPool::block_size(16 * 1024), 16 * 1024);
+    EXPECT_EQ(BufferPool::block_size(BufferPool::kMaxBlockSize), BufferPool::kMaxBlockSize);
+
+    // 超过最大级别的不做取整
+    EXPECT_EQ(BufferPool::block_size(BufferPool::kMaxBlockSize + 1), BufferPool::kMaxBlockSize + 1);
+}
+
+
+// TAG: 归还后的内存被复用
+TEST(BufferPoolTest, ReuseInOwnerThread) {
+    BufferPool pool(CurrentThread::tid());
+
+    void* p = pool.allocate(1000);
+    pool.deallocate(p, 1000);
+    EXPECT_EQ(pool.cached_bytes(), 1024);
+
+    // 同一级别的申请拿到同一块内存
+    void* q = pool.allocate(600);
+    EXPECT_EQ(p, q);
+    EXPECT_EQ(pool.cached_bytes(), 0);
+
+    // 不同级别互不影响
+    void* r = pool.allocate(4096);
+    EXPECT_NE(q, r);
+
+    pool.deallocate(q, 600);
+    pool.deallocate(r, 4096);
+    EXPECT_EQ(pool.cached_bytes(), 1024 + 4096);
+}
+
+
+// TAG: 其它线程归还的内存不进入空闲链表
+TEST(BufferPoolTest, DeallocateFromOtherThread) {
+    BufferPool pool(CurrentThread::tid());
+
+    void* p = pool.allocate(2048);
+    std::thread t([&] {
+        pool.deallocate(p, 2048);
+    });
+    t.join();
+
+    EXPECT_EQ(pool.cached_bytes(), 0);
+}
+
+
+// TAG: 缓冲区从内存池中借出并归还内存
+TEST(BufferPoolTest, BufferBorrowAndRelease) {
+    auto pool = std::make_shared<BufferPool>(CurrentThread::tid());
+
+    // 绑定内存池的缓冲区在第一次写入时才申请内存
+    Buffer buf(8, 1016, pool);
+    EXPECT_TRUE(buf.released());
+    EXPECT_EQ(buf.writable(), 0);
+
+    buf.append("pooled", 6);
+    EXPECT_FALSE(buf.released());
+    EXPECT_EQ(buf.readable(), 6);
+    EXPECT_EQ(buf.writable(), 1016 - 6);
+
+    // 有数据时不能归还
+    EXPECT_FALSE(buf.release());
+    EXPECT_EQ(buf.retrieve_all_as_string(), "pooled");
+
+    EXPECT_TRUE(buf.release());
+    EXPECT_TRUE(buf.released());
+    EXPECT_EQ(pool->cached_bytes(), 1024);
+
+    // 再次写入时从内存池中重新借出
+    buf.append("again", 5);
+    EXPECT_EQ(pool->cached_bytes(), 0);
+    EXPECT_EQ(buf.retrieve_all_as_string(), "again");
+}
+
+
+// TAG: 缓冲区按整块使用借出的内存, capacity与借出的块大小一致
+TEST(BufferPoolTest, BufferUsesWholeBlock) {
+    auto pool = std::make_shared<BufferPool>(CurrentThread::tid());
+    Buffer buf(8, 1016, pool);
+
+    buf.append(std::string(66000, 'g'));
+    EXPECT_EQ(buf.capacity(), BufferPool::block_size(66008));
+    EXPECT_EQ(buf.prependable() + buf.readable() + buf.writable(), buf.capacity());
+
+    // 收缩后同样按块的大小计算
+    buf.retrieve(65990);
+    buf.shrink(1016);
+    EXPECT_EQ(buf.capacity(), 2048);
+    EXPECT_EQ(buf.readable(), 10);
+    EXPECT_EQ(buf.writable(), 2048 - 8 - 10);
+
+    buf.retrieve_all();
+    EXPECT_TRUE(buf.release());
+    EXPECT_EQ(pool->cached_bytes(), 128 * 1024 + 2048);
+}
+
+
+// TAG: 链式缓冲区的块从内存池中借出
+TEST(BufferPoolTest, ChainBufferBlocks) {
+    auto pool = std::make_shared<BufferPool>(CurrentThread::tid());
+
+    {
+        ChainBuffer buf(pool);
+        buf.append(std::string(ChainBuffer::kBlockSize * 2, 'c'));
+        EXPECT_EQ(buf.num_blocks(), 2);
+
+        buf.retrieve_all();
+        EXPECT_EQ(pool->cached_bytes(), ChainBuffer::kBlockSize * 2);
+
+        buf.append("x", 1);
+        EXPECT_EQ(pool->cached_bytes(), ChainBuffer::kBlockSize);
+    }
+
+    // 析构时剩余的块也归还给内存池
+    EXPECT_EQ(pool->cached_bytes(), ChainBuffer::kBlockSize * 2);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,221 @@
+#include "mymuduo/base/CurrentThread.h"
+#include "mymuduo/net/ChainBuffer.h"
+
+#include <fcntl.h>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+namespace {
+
+// TAG: 基本操作测试
+TEST(ChainBufferTest, BasicOperations) {
+    ChainBuffer buf;
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(buf.num_blocks(), 0);
+
+    const std::string msg = "Hello, ChainBuffer!";
+    buf.append(msg);
+    EXPECT_EQ(buf.readable(), msg.size());
+    EXPECT_EQ(buf.num_blocks(), 1);
+
+    buf.retrieve(7);
+    EXPECT_EQ(buf.readable(), msg.size() - 7);
+    EXPECT_EQ(buf.retrieve_all_as_string(), "ChainBuffer!");
+    EXPECT_TRUE(buf.empty());
+    EXPECT_EQ(buf.num_blocks(), 0);
+}
+
+
+// TAG: 跨块追加与检索
+TEST(ChainBufferTest, SpanMultipleBlocks) {
+    ChainBuffer buf;
+
+    // 大数据被切分到多个块中, 而不是一次性分配连续内存
+    std::string large(ChainBuffer::kBlockSize * 3 + 100, 'x');
+    for(std::size_t i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<char>('a' + i % 26);
+    }
+    buf.append(large);
+    EXPECT_EQ(buf.readable(), large.size());
+    EXPECT_EQ(buf.num_blocks(), 4);
+
+    // 跨块检索
+    buf.retrieve(ChainBuffer::kBlockSize + 10);
+    EXPECT_EQ(buf.num_blocks(), 3);
+    EXPECT_EQ(buf.retrieve_all_as_string(), large.substr(ChainBuffer::kBlockSize + 10));
+}
+
+
+// TAG: writev 集中写
+TEST(ChainBufferTest, WriteFd) {
+    int pipefd[2];
+    ASSERT_EQ(pipe(pipefd), 0);
+
+    ChainBuffer buf;
+    std::string first(ChainBuffer::kBlockSize - 4, 'a');
+    std::string second(32, 'b');
+    buf.append(first);
+    buf.append(second);
+    EXPECT_EQ(buf.num_blocks(), 2);
+
+    int err = 0;
+    ssize_t written = buf.write_fd(pipefd[1], &err);
+    EXPECT_EQ(written, first.size() + second.size());
+    EXPECT_EQ(err, 0);
+    EXPECT_TRUE(buf.empty());
+
+    std::string received(written, '\0');
+    ASSERT_EQ(::read(pipefd[0], received.data(), received.size()), written);
+    EXPECT_EQ(received, first + second);
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+
+// TAG: 部分写入后剩余数据保持有序
+TEST(ChainBufferTest, PartialWrite) {
+    int pipefd[2];
+    ASSERT_EQ(pipe2(pipefd, O_NONBLOCK), 0);
+
+    // 将管道容量限制为一页, 迫使 writev 只写入一部分
+    int cap = ::fcntl(pipefd[1], F_SETPIPE_SZ, 4096);
+    ASSERT_GT(cap, 0);
+
+    std::string data(cap * 3, 'z');
+    for(std::size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>('0' + i % 10);
+    }
+
+    ChainBuffer buf;
+    buf.append(data);
+
+    int err = 0;
+    ssize_t written = buf.write_fd(pipefd[1], &err);
+    ASSERT_GT(written, 0);
+    ASSERT_LT(written, data.size());
+    EXPECT_EQ(buf.readable(), data.size() - written);
+
+    // 管道已满
+    EXPECT_LT(buf.write_fd(pipefd[1], &err), 0);
+    EXPECT_EQ(err, EAGAIN);
+
+    EXPECT_EQ(buf.retrieve_all_as_string(), data.substr(written));
+
+    close(pipefd[0]);
+    close(pipefd[1]);
+}
+
+
+// TAG: 锁定的块在数据被取走, 甚至ChainBuffer析构之后仍然有效, 且不会被复用
+TEST(ChainBufferTest, PinnedBlockOutlivesBuffer) {
+    auto pool = std::make_shared<BufferPool>(CurrentThread::tid());
+    std::shared_ptr<const void> pin;
+    const char* data = nullptr;
+    {
+        ChainBuffer buf(pool);
+        struct iovec iov[ChainBuffer::kMaxIovecs];
+        int iov_count = 0;
+
+        buf.append(std::string(100, 'p'));
+        pin = buf.pin_iovecs(iov, &iov_count);
+        ASSERT_NE(pin, nullptr);
+        ASSERT_EQ(iov_count, 1);
+        EXPECT_EQ(iov[0].iov_len, 100u);
+        data = static_cast<const char*>(iov[0].iov_base);
+
+        // 同一个块只创建一次句柄
+        EXPECT_EQ(buf.pin_iovecs(iov, &iov_count), pin);
+        buf.retrieve_all();
+        EXPECT_EQ(buf.pin_iovecs(iov, &iov_count), nullptr);
+
+        // 新的块不会复用被锁定的内存
+        buf.append(std::string(10, 'n'));
+        buf.pin_iovecs(iov, &iov_count);
+        EXPECT_NE(iov[0].iov_base, data);
+    }
+
+    EXPECT_EQ(std::string(data, 100), std::string(100, 'p'));
+
+    // 最后一个持有者释放后归还给内存池
+    pin.reset();
+    void* block = pool->allocate(ChainBuffer::kBlockSize);
+    EXPECT_EQ(block, data);
+    pool->deallocate(block, ChainBuffer::kBlockSize);
+}
+
+
+// TAG: 锁定多个块用于一次异步发送, 块在句柄释放后才归还内存池
+TEST(ChainBufferTest, PinIovecs) {
+    auto pool = std::make_shared<BufferPool>(CurrentThread::tid());
+    ChainBuffer buf(pool);
+
+    struct iovec iov[ChainBuffer::kMaxIovecs];
+    int iov_count = -1;
+    EXPECT_EQ(buf.pin_iovecs(iov, &iov_count), nullptr);
+    EXPECT_EQ(iov_count, 0);
+
+    const std::string data = std::string(ChainBuffer::kBlockSize, 'a')
+                           + std::string(ChainBuffer::kBlockSize, 'b')
+                           + std::string(100, 'c');
+    buf.append(data);
+
+    auto pin = buf.pin_iovecs(iov, &iov_count, 2 * ChainBuffer::kBlockSize + 10);
+    ASSERT_NE(pin, nullptr);
+    ASSERT_EQ(iov_count, 3);
+    EXPECT_EQ(iov[0].iov_len, ChainBuffer::kBlockSize);
+    EXPECT_EQ(iov[1].iov_len, ChainBuffer::kBlockSize);
+    EXPECT_EQ(iov[2].iov_len, 10u);
+
+    std::string joined;
+    for(int i = 0; i < iov_count; ++i) {
+        joined.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    EXPECT_EQ(joined, data.substr(0, joined.size()));
+
+    // 取走数据后块仍然有效, 也不会被新的块复用
+    const char* first = static_cast<const char*>(iov[0].iov_base);
+    buf.retrieve_all();
+    buf.append(std::string(10, 'n'));
+    auto next = buf.pin_iovecs(iov, &iov_count);
+    ASSERT_EQ(iov_count, 1);
+    EXPECT_NE(iov[0].iov_base, first);
+    EXPECT_EQ(std::string(first, 3), "aaa");
+
+    pin.reset();
+    void* block = pool->allocate(ChainBuffer::kBlockSize);
+    EXPECT_NE(block, nullptr);
+    pool->deallocate(block, ChainBuffer::kBlockSize);
+}
+
+// TAG: 读空的块立即释放, 未绑定内存池时缓存的空闲块由 shrink 释放
+TEST(ChainBufferTest, ShrinkSpareBlocks) {
+    ChainBuffer buf;
+    buf.append(std::string(4 * ChainBuffer::kBlockSize, 's'));
+    EXPECT_EQ(buf.capacity(), 4 * ChainBuffer::kBlockSize);
+
+    buf.retrieve_all();
+    EXPECT_EQ(buf.num_blocks(), 0u);
+    EXPECT_EQ(buf.capacity(), ChainBuffer::kMaxSpareBlocks * ChainBuffer::kBlockSize);
+
+    buf.shrink();
+    EXPECT_EQ(buf.capacity(), 0u);
+
+    // 绑定内存池时不缓存空闲块
+    ChainBuffer pooled(std::make_shared<BufferPool>(CurrentThread::tid()));
+    pooled.append(std::string(4 * ChainBuffer::kBlockSize, 'p'));
+    pooled.retrieve_all();
+    EXPECT_EQ(pooled.capacity(), 0u);
+}
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
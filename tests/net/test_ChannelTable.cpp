@@ -0,0 +1,107 @@
+#include "mymuduo/net/Channel.h"
+#include "mymuduo/net/ChannelTable.h"
+
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+
+// TAG: 注册, 查找与删除
+TEST(ChannelTableTest, InsertFindErase) {
+    ChannelTable table;
+    Channel a(nullptr, 3);
+    Channel b(nullptr, 7);
+
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(table.find(3), nullptr);
+    EXPECT_EQ(table.find(-1), nullptr);
+
+    table.insert(&a);
+    table.insert(&b);
+    EXPECT_EQ(table.size(), 2u);
+    EXPECT_EQ(table.find(3), &a);
+    EXPECT_EQ(table.find(7), &b);
+    EXPECT_EQ(table.find(5), nullptr);
+    EXPECT_EQ(table.find(100), nullptr);
+    EXPECT_TRUE(table.contains(&a));
+
+    table.erase(3);
+    table.erase(3);
+    table.erase(100);
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_EQ(table.find(3), nullptr);
+    EXPECT_FALSE(table.contains(&a));
+    EXPECT_TRUE(table.contains(&b));
+}
+
+
+// TAG: fd复用时代数加一, 旧代数的查找失败
+TEST(ChannelTableTest, GenerationOnReuse) {
+    ChannelTable table;
+    Channel old_ch(nullptr, 4);
+    Channel new_ch(nullptr, 4);
+
+    const uint32_t g1 = table.insert(&old_ch);
+    EXPECT_EQ(table.generation(4), g1);
+    EXPECT_EQ(table.find(4, g1), &old_ch);
+
+    table.erase(4);
+    EXPECT_EQ(table.generation(4), g1);
+    EXPECT_EQ(table.find(4, g1), nullptr);
+
+    const uint32_t g2 = table.insert(&new_ch);
+    EXPECT_NE(g1, g2);
+    EXPECT_EQ(table.find(4, g1), nullptr);
+    EXPECT_EQ(table.find(4, g2), &new_ch);
+    EXPECT_FALSE(table.contains(&old_ch));
+}
+
+
+// TAG: 旧的Channel未删除时被覆盖, 计数不变
+TEST(ChannelTableTest, OverwriteWithoutErase) {
+    ChannelTable table;
+    Channel old_ch(nullptr, 2);
+    Channel new_ch(nullptr, 2);
+
+    const uint32_t g1 = table.insert(&old_ch);
+    const uint32_t g2 = table.insert(&new_ch);
+    EXPECT_EQ(table.size(), 1u);
+    EXPECT_EQ(table.find(2), &new_ch);
+    EXPECT_EQ(table.find(2, g1), nullptr);
+    EXPECT_EQ(table.find(2, g2), &new_ch);
+}
+
+
+// TAG: 按最大的fd扩容, 已有的槽位保持不变
+TEST(ChannelTableTest, Grow) {
+    ChannelTable table;
+    std::vector<std::unique_ptr<Channel>> channels;
+    for(int fd = 0; fd < 1000; ++fd) {
+        channels.emplace_back(std::make_unique<Channel>(nullptr, fd));
+        table.insert(channels.back().get());
+    }
+    EXPECT_EQ(table.size(), 1000u);
+    EXPECT_GE(table.capacity(), 1000u);
+
+    Channel far(nullptr, 100000);
+    table.insert(&far);
+    EXPECT_GE(table.capacity(), 100001u);
+    EXPECT_EQ(table.find(100000), &far);
+
+    for(int fd = 0; fd < 1000; ++fd) {
+        EXPECT_EQ(table.find(fd), channels[fd].get());
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
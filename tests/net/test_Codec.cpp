@@ -0,0 +1,169 @@
+#include "mymuduo/net/Buffer.h"
+#include "mymuduo/net/Codec.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+using namespace mymuduo::net::codec;
+
+namespace {
+
+// 编码后逐字节送入缓冲区, 只有最后一个字节到达时才能解出报文
+template <typename Codec>
+void expect_round_trip(const Codec& c, const std::string& body) {
+    std::string frame;
+    ASSERT_TRUE(c.encode(body, frame));
+
+    Buffer buf;
+    std::string_view out;
+    std::size_t frame_len = 0;
+
+    for(std::size_t i = 0; i + 1 < frame.size(); ++i) {
+        buf.append(frame.data() + i, 1);
+        ASSERT_EQ(c.decode(buf, out, frame_len), DecodeStatus::kIncomplete);
+    }
+    buf.append(frame.data() + frame.size() - 1, 1);
+
+    ASSERT_EQ(c.decode(buf, out, frame_len), DecodeStatus::kComplete);
+    EXPECT_EQ(out, body);
+    EXPECT_EQ(frame_len, frame.size());
+}
+
+
+// TAG: 大端序定长报文头
+TEST(CodecTest, LengthPrefix) {
+    static_assert(FramingCodec<LengthPrefixCodec<4>>);
+
+    LengthPrefixCodec<4> c4;
+    std::string frame;
+    ASSERT_TRUE(c4.encode("abc", frame));
+    EXPECT_EQ(frame, std::string("\0\0\0\x03" "abc", 7));
+
+    expect_round_trip(LengthPrefixCodec<2>{}, "two bytes header");
+    expect_round_trip(LengthPrefixCodec<4>{}, std::string(300, 'x'));
+    expect_round_trip(LengthPrefixCodec<8>{}, "eight bytes header");
+    expect_round_trip(LengthPrefixCodec<4>{}, "");
+
+    // 2字节的报文头放不下 65536
+    frame.clear();
+    EXPECT_FALSE(LengthPrefixCodec<2>{}.encode(std::string(65536, 'y'), frame));
+}
+
+
+// TAG: 超过最大长度的报文
+TEST(CodecTest, MaxFrameSize) {
+    LengthPrefixCodec<4> c(16);
+
+    std::string frame;
+    EXPECT_FALSE(c.encode(std::string(17, 'z'), frame));
+
+    // 对端声明了超长的报文, 不必等数据到齐就能判定为非法
+    Buffer buf;
+    buf.append("\0\0\0\x20", 4);
+    std::string_view body;
+    std::size_t frame_len = 0;
+    EXPECT_EQ(c.decode(buf, body, frame_len), DecodeStatus::kError);
+}
+
+
+// TAG: varint报文头
+TEST(CodecTest, Varint) {
+    static_assert(FramingCodec<VarintLengthCodec>);
+
+    VarintLengthCodec c;
+    std::string frame;
+    ASSERT_TRUE(c.encode(std::string(300, 'v'), frame));
+
+    // 300 = 0b10_0101100 -> 0xAC 0x02
+    EXPECT_EQ(static_cast<unsigned char>(frame[0]), 0xAC);
+    EXPECT_EQ(static_cast<unsigned char>(frame[1]), 0x02);
+    EXPECT_EQ(frame.size(), 302);
+
+    expect_round_trip(c, "short");
+    expect_round_trip(c, std::string(20000, 'w'));
+
+    // 超过10个字节仍未结束的报文头是非法的
+    Buffer buf;
+    buf.append(std::string(11, '\x80'));
+    std::string_view body;
+    std::size_t frame_len = 0;
+    EXPECT_EQ(c.decode(buf, body, frame_len), DecodeStatus::kError);
+
+    // 第10个字节超出64位的部分不能被丢弃, 否则 0x80 * 9 + 0x02 会被解析为长度0
+    Buffer overflow;
+    overflow.append(std::string(9, '\x80') + '\x02');
+    EXPECT_EQ(c.decode(overflow, body, frame_len), DecodeStatus::kError);
+}
+
+
+// TAG: 分割符
+TEST(CodecTest, Delimiter) {
+    static_assert(FramingCodec<DelimiterCodec>);
+
+    expect_round_trip(DelimiterCodec{}, "crlf delimited");
+    expect_round_trip(DelimiterCodec{"|"}, "pipe delimited");
+
+    // 内容中含有分割符的报文无法正确分帧, 拒绝编码
+    std::string frame;
+    EXPECT_FALSE(DelimiterCodec{"|"}.encode("a|b", frame));
+
+    // 超过最大长度仍未找到分割符
+    DelimiterCodec c("\n", 8);
+    Buffer buf;
+    buf.append(std::string(10, 'n'));
+    std::string_view body;
+    std::size_t frame_len = 0;
+    EXPECT_EQ(c.decode(buf, body, frame_len), DecodeStatus::kError);
+}
+
+
+// TAG: 定长报文
+TEST(CodecTest, FixedSize) {
+    static_assert(FramingCodec<FixedSizeCodec>);
+
+    FixedSizeCodec c(8);
+    expect_round_trip(c, "12345678");
+
+    std::string frame;
+    EXPECT_FALSE(c.encode("short", frame));
+}
+
+
+// TAG: 由编解码器生成的消息回调一次取出所有完整的报文
+TEST(CodecTest, MessageCallback) {
+    LengthPrefixCodec<2> c;
+
+    std::vector<std::string> frames;
+    MessageCallback cb = make_message_callback(c,
+        [&](const TcpConnectionPtr& conn, std::string_view body, Timestamp t) {
+            frames.emplace_back(body);
+        });
+
+    Buffer buf;
+    c.encode("first", buf);
+    c.encode("second", buf);
+    buf.append("\0\x05" "thi", 5);
+
+    cb(TcpConnectionPtr{}, &buf, Timestamp::now());
+    ASSERT_EQ(frames.size(), 2);
+    EXPECT_EQ(frames[0], "first");
+    EXPECT_EQ(frames[1], "second");
+    EXPECT_EQ(buf.readable(), 5);
+
+    buf.append("rd", 2);
+    cb(TcpConnectionPtr{}, &buf, Timestamp::now());
+    ASSERT_EQ(frames.size(), 3);
+    EXPECT_EQ(frames[2], "third");
+    EXPECT_EQ(buf.readable(), 0);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
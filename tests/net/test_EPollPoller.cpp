@@ -0,0 +1,313 @@
+#include "mymuduo/net/Channel.h"
+#include "mymuduo/net/EventLoop.h"
+#include "mymuduo/net/SocketOps.h"
+#include "mymuduo/net/poller/EPollPoller.h"
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+class EPollPollerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        _loop = std::make_unique<EventLoop>();
+        _poller = dynamic_cast<EPollPoller*>(_loop->poller());
+        ASSERT_NE(_poller, nullptr);
+
+        int fds[2];
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+        _fd = fds[0];
+        _peer = fds[1];
+
+        // 先提交EventLoop自身Channel(唤醒, 定时器)的注册
+        _loop->loop_once(0ms);
+    }
+
+    void TearDown() override {
+        remove_ready_channels();
+        sockets::close(_fd);
+        sockets::close(_peer);
+    }
+
+    // 注册n个一直可读的eventfd(LT下每一轮都会就绪)
+    void add_ready_channels(int n, std::vector<int>* reads) {
+        reads->assign(n, 0);
+        for(int i = 0; i < n; ++i) {
+            const int fd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+            auto ch = std::make_unique<Channel>(_loop.get(), fd);
+            ch->set_read_callback([reads, i](Timestamp) { ++(*reads)[i]; });
+            ch->set_read_events();
+            _ready.emplace_back(std::move(ch));
+        }
+    }
+
+    // 读空所有eventfd, 之后不再就绪
+    void drain_ready_channels() {
+        for(auto& ch : _ready) {
+            uint64_t value;
+            ::read(ch->fd(), &value, sizeof(value));
+        }
+    }
+
+    void remove_ready_channels() {
+        for(auto& ch : _ready) {
+            ch->unset_all_events();
+            ch->remove();
+            sockets::close(ch->fd());
+        }
+        _ready.clear();
+    }
+
+protected:
+    std::unique_ptr<EventLoop> _loop;
+    EPollPoller* _poller = nullptr;
+    std::vector<std::unique_ptr<Channel>> _ready;
+    int _fd = -1;
+    int _peer = -1;
+};
+
+
+// TAG: 同一轮内开关EPOLLOUT相互抵消, 不调用epoll_ctl
+TEST_F(EPollPollerTest, ToggleCancelsOut) {
+    int writes = 0;
+    Channel ch(_loop.get(), _fd);
+    ch.set_write_callback([&] { ++writes; });
+    ch.set_read_events();
+    _loop->loop_once(10ms);
+
+    const std::size_t calls = _poller->ctl_calls();
+    for(int i = 0; i < 10; ++i) {
+        ch.set_write_events();
+        ch.unset_write_events();
+    }
+    _loop->loop_once(10ms);
+    EXPECT_EQ(_poller->ctl_calls(), calls);
+    EXPECT_EQ(writes, 0);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: 多次修改只提交最终的净修改, 且在epoll_wait之前生效
+TEST_F(EPollPollerTest, NetChangeApplied) {
+    int reads = 0;
+    int writes = 0;
+    Channel ch(_loop.get(), _fd);
+    ch.set_read_callback([&](Timestamp) { ++reads; });
+    ch.set_write_callback([&] { ++writes; });
+
+    std::size_t calls = _poller->ctl_calls();
+    ch.set_read_events();
+    ch.set_write_events();
+    ch.unset_read_events();
+    EXPECT_EQ(_poller->ctl_calls(), calls);
+
+    ASSERT_EQ(::write(_peer, "x", 1), 1);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(_poller->ctl_calls(), calls + 1);     // 一次ADD
+    EXPECT_EQ(reads, 0);
+    EXPECT_EQ(writes, 1);
+
+    calls = _poller->ctl_calls();
+    ch.set_read_events();
+    ch.unset_write_events();
+    _loop->loop_once(100ms);
+    EXPECT_EQ(_poller->ctl_calls(), calls + 1);     // 一次MOD
+    EXPECT_EQ(reads, 1);
+    EXPECT_EQ(writes, 1);
+
+    // 取消所有事件立即生效
+    calls = _poller->ctl_calls();
+    ch.unset_all_events();
+    EXPECT_EQ(_poller->ctl_calls(), calls + 1);     // 一次DEL
+    _loop->loop_once(10ms);
+    EXPECT_EQ(_poller->ctl_calls(), calls + 1);
+    EXPECT_EQ(reads, 1);
+
+    ch.remove();
+    EXPECT_EQ(_poller->ctl_calls(), calls + 1);
+}
+
+
+// TAG: 取消所有事件与remove_channel立即从epoll中删除; 还未提交的Channel直接丢弃修改
+TEST_F(EPollPollerTest, RemoveIsImmediate) {
+    int reads = 0;
+    {
+        Channel ch(_loop.get(), _fd);
+        ch.set_read_events();
+        _loop->loop_once(10ms);
+
+        const std::size_t calls = _poller->ctl_calls();
+        ch.unset_all_events();
+        ch.remove();
+        EXPECT_EQ(_poller->ctl_calls(), calls + 1);
+    }
+    {
+        Channel ch(_loop.get(), _fd);
+        const std::size_t calls = _poller->ctl_calls();
+        ch.set_read_events();
+        ch.unset_all_events();
+        ch.remove();
+        _loop->loop_once(10ms);
+        EXPECT_EQ(_poller->ctl_calls(), calls);
+    }
+
+    // 同一fd上的新Channel正常注册
+    Channel ch(_loop.get(), _fd);
+    ch.set_read_callback([&](Timestamp) { ++reads; });
+    ch.set_read_events();
+    ASSERT_EQ(::write(_peer, "x", 1), 1);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 1);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+
+// TAG: epoll中残留的旧注册(文件被dup而未真正关闭)在fd复用后不会触发新的Channel
+TEST_F(EPollPollerTest, StaleEventAfterFdReuse) {
+    int stale_reads = 0;
+    int reads = 0;
+
+    const int old_fd = _fd;
+    const int dup_fd = ::dup(old_fd);
+    ASSERT_GE(dup_fd, 0);
+    {
+        Channel ch(_loop.get(), old_fd);
+        ch.set_read_callback([&](Timestamp) { ++stale_reads; });
+        ch.set_read_events();
+        _loop->loop_once(10ms);
+
+        // 关闭fd后文件仍被dup_fd引用, 内核中的注册保留, 之后的DEL失败
+        ::close(old_fd);
+        ch.remove();
+    }
+
+    // 新的socket复用同一个fd
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+    ASSERT_EQ(fds[0], old_fd);
+    _fd = fds[0];
+
+    Channel ch(_loop.get(), _fd);
+    ch.set_read_callback([&](Timestamp) { ++reads; });
+    ch.set_read_events();
+
+    // 旧文件可读, 事件带有旧的代数, 被丢弃
+    ASSERT_EQ(::write(_peer, "x", 1), 1);
+    _loop->loop_once(50ms);
+    EXPECT_EQ(stale_reads, 0);
+    EXPECT_EQ(reads, 0);
+
+    ASSERT_EQ(::write(fds[1], "y", 1), 1);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 1);
+
+    ch.unset_all_events();
+    ch.remove();
+    sockets::close(fds[1]);
+    sockets::close(dup_fd);
+}
+
+
+
+// TAG: 接收事件数组被填满时加倍, 直到能容纳所有就绪的fd
+TEST_F(EPollPollerTest, GrowsWhenSaturated) {
+    std::vector<int> reads;
+    add_ready_channels(100, &reads);
+    EXPECT_EQ(_poller->event_capacity(), EPollPoller::kInitEvents);
+
+    for(int i = 0; i < 4; ++i) {
+        _loop->loop_once(0ms);
+    }
+    EXPECT_EQ(_poller->event_capacity(), 128u);
+    EXPECT_EQ(_poller->saturated_polls(), 3u);      // 16, 32, 64
+
+    _loop->loop_once(0ms);
+    EXPECT_EQ(_poller->event_capacity(), 128u);
+    for(int n : reads) {
+        EXPECT_GE(n, 1);
+    }
+
+    const Histogram::Snapshot ready = _poller->ready_events();
+    EXPECT_EQ(ready.max, 100u);
+    EXPECT_GE(ready.buckets[Histogram::bucket_index(16)], 1u);
+    EXPECT_GE(ready.buckets[Histogram::bucket_index(100)], 2u);
+}
+
+
+// TAG: 不超过上限; 就绪的fd多于上限时分多轮取到, 每个fd都能得到处理
+TEST_F(EPollPollerTest, RespectsCap) {
+    _poller->set_max_events(32);
+    EXPECT_EQ(_poller->max_events(), 32u);
+
+    std::vector<int> reads;
+    add_ready_channels(100, &reads);
+    for(int i = 0; i < 10; ++i) {
+        _loop->loop_once(0ms);
+    }
+    EXPECT_EQ(_poller->event_capacity(), 32u);
+    EXPECT_EQ(_poller->ready_events().max, 32u);
+    for(int n : reads) {
+        EXPECT_GE(n, 1);
+    }
+
+    // 调小上限时下一轮立即缩小, 且不低于初始大小
+    _poller->set_max_events(1);
+    EXPECT_EQ(_poller->max_events(), EPollPoller::kInitEvents);
+    _loop->loop_once(0ms);
+    EXPECT_EQ(_poller->event_capacity(), EPollPoller::kInitEvents);
+}
+
+
+// TAG: 连续多轮占用不到四分之一时减半, 直到初始大小
+TEST_F(EPollPollerTest, ShrinksWhenIdle) {
+    std::vector<int> reads;
+    add_ready_channels(100, &reads);
+    for(int i = 0; i < 4; ++i) {
+        _loop->loop_once(0ms);
+    }
+    ASSERT_EQ(_poller->event_capacity(), 128u);
+
+    drain_ready_channels();
+    for(unsigned i = 0; i + 1 < EPollPoller::kShrinkAfter; ++i) {
+        _loop->loop_once(0ms);
+    }
+    EXPECT_EQ(_poller->event_capacity(), 128u);
+    _loop->loop_once(0ms);
+    EXPECT_EQ(_poller->event_capacity(), 64u);
+
+    for(unsigned i = 0; i < 2 * EPollPoller::kShrinkAfter; ++i) {
+        _loop->loop_once(0ms);
+    }
+    EXPECT_EQ(_poller->event_capacity(), EPollPoller::kInitEvents);
+
+    for(unsigned i = 0; i < EPollPoller::kShrinkAfter; ++i) {
+        _loop->loop_once(0ms);
+    }
+    EXPECT_EQ(_poller->event_capacity(), EPollPoller::kInitEvents);
+}
+
+}
+
+int main(int argc, char** argv) {
+    // 本测试中所有的EventLoop都使用epoll
+    ::unsetenv("MUDUO_USE_POLL");
+    ::unsetenv("MUDUO_USE_URING");
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -134,6 +134,47 @@ TEST_F(EventLoopTest, ScheduleWithoutRunningLoop) {
 }
 
 
+// TAG: 测试唤醒合并
+TEST_F(EventLoopTest, WakeupCoalescing) {
+    std::atomic<int> count { 0 };
+
+    // loop没有阻塞在poll中时, 其它线程投递任务不会写eventfd
+    std::thread producer([&] {
+        for(int i = 0; i < 100; ++i) {
+            _loop->queue_in_loop([&] { ++count; });
+        }
+    });
+    producer.join();
+    EXPECT_EQ(_loop->wakeup_writes(), 0);
+
+    // 阻塞前发现有任务, 不会等到超时
+    auto start = Timestamp::now();
+    _loop->loop_once(1s);
+    EXPECT_LT(time_difference(Timestamp::now(), start), 500000);
+    EXPECT_EQ(count.load(), 100);
+
+    // loop阻塞在poll中时, 大量的投递只需要少量的唤醒
+    startAnotherLoop();
+    while(!_another->looping()) {
+        usleep(1000);
+    }
+    usleep(10000);
+
+    count = 0;
+    for(int i = 0; i < 1000; ++i) {
+        _another->queue_in_loop([&] { ++count; });
+    }
+
+    int waitCount = 0;
+    while(count.load() < 1000 && waitCount++ < 100) {
+        usleep(10000);
+    }
+    EXPECT_EQ(count.load(), 1000);
+    EXPECT_GE(_another->wakeup_writes(), 1);
+    EXPECT_LT(_another->wakeup_writes(), 1000);
+}
+
+
 // TAG: 测试跨线程定时器调度
 TEST_F(EventLoopTest, CrossThreadTimer) {
     startAnotherLoop();
@@ -158,6 +199,72 @@ TEST_F(EventLoopTest, CrossThreadTimer) {
     EXPECT_TRUE(timerCalled.load());
 }
 
+
+// TAG: 每轮循环的运行指标
+TEST_F(EventLoopTest, Metrics) {
+    EventLoopMetrics::Snapshot m = _loop->metrics();
+    EXPECT_EQ(m.iterations, 0);
+    EXPECT_EQ(m.loops, 1);
+
+    for(int i = 0; i < 10; ++i) {
+        _loop->queue_in_loop([] { usleep(1000); });
+    }
+    EXPECT_EQ(_loop->metrics().task_backlog, 10);
+
+    // 有任务时不阻塞, 一轮执行完所有任务
+    _loop->loop_once(1s);
+    m = _loop->metrics();
+    EXPECT_EQ(m.iterations, 1);
+    EXPECT_EQ(m.tasks, 10);
+    EXPECT_EQ(m.task_backlog, 0);
+    EXPECT_EQ(m.drained_tasks.max, 10);
+    EXPECT_GE(m.functors_ns.sum, 10 * 1000 * 1000);
+    EXPECT_LT(m.poll_wait_ns.sum, m.functors_ns.sum);
+
+    // 空闲时的时间计入poll_wait
+    _loop->loop_once(20ms);
+    m = _loop->metrics();
+    EXPECT_EQ(m.iterations, 2);
+    EXPECT_EQ(m.drained_tasks.buckets[0], 1);
+    EXPECT_GE(m.poll_wait_ns.max, 10 * 1000 * 1000);
+}
+
+
+// TAG: 每轮执行任务的预算, 剩余的任务留到下一轮且不会阻塞在poll中
+TEST_F(EventLoopTest, TaskBudget) {
+    std::atomic<int> count { 0 };
+
+    _loop->set_task_budget(10);
+    for(int i = 0; i < 100; ++i) {
+        _loop->queue_in_loop([&] { ++count; });
+    }
+
+    auto start = Timestamp::now();
+    for(int i = 1; i <= 10; ++i) {
+        _loop->loop_once(1s);
+        EXPECT_EQ(count.load(), i * 10);
+        EXPECT_EQ(_loop->metrics().task_backlog, 100 - i * 10);
+    }
+    EXPECT_LT(time_difference(Timestamp::now(), start), 500 * 1000 * 1000);
+
+    // 时间预算: 每执行 kTaskBudgetCheckInterval 个任务检查一次
+    count = 0;
+    _loop->set_task_budget(0, 1000us);
+    for(int i = 0; i < 100; ++i) {
+        _loop->queue_in_loop([&] { ++count; usleep(100); });
+    }
+
+    _loop->loop_once(1s);
+    EXPECT_GE(count.load(), EventLoop::kTaskBudgetCheckInterval);
+    EXPECT_LT(count.load(), 100);
+
+    start = Timestamp::now();
+    while(count.load() < 100) {
+        _loop->loop_once(1s);
+    }
+    EXPECT_LT(time_difference(Timestamp::now(), start), 500 * 1000 * 1000);
+}
+
 } // 匿名
 
 int main(int argc, char** argv) {
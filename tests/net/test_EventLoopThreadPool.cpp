@@ -9,6 +9,8 @@
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <future>
+#include <sched.h>
 #include <thread>
 #include <unistd.h>
 
@@ -257,6 +259,114 @@ TEST_F(EventLoopThreadPoolTest, ConcurrentAccess) {
     ASSERT_EQ(Total, _callbackCount.load());
 }
 
+
+// TAG: 按loop选择忙轮询模式, 空闲时自旋时长自适应减少
+TEST_F(EventLoopThreadPoolTest, BusyPoll) {
+    _pool->set_thread_num(3);
+    _pool->set_busy_poll(200us);
+    _pool->set_busy_poll(1, 0us);
+    _pool->start();
+
+    auto loops = _pool->get_all_loops();
+    ASSERT_EQ(loops.size(), 3);
+    EXPECT_EQ(loops[0]->busy_poll(), 200us);
+    EXPECT_EQ(loops[1]->busy_poll(), 0us);
+    EXPECT_EQ(loops[2]->busy_poll(), 200us);
+
+    // 自旋中的loop不需要eventfd唤醒也能执行任务
+    std::atomic<int> count { 0 };
+    for(int i = 0; i < 100; ++i) {
+        loops[0]->queue_in_loop([&] { ++count; });
+    }
+    int waitCount = 0;
+    while(count.load() < 100 && waitCount++ < 100) {
+        usleep(10000);
+    }
+    EXPECT_EQ(count.load(), 100);
+
+    // 空闲一段时间后, 自旋时长应已衰减到上限以下
+    usleep(50000);
+    std::promise<std::chrono::microseconds> budget;
+    loops[0]->queue_in_loop([&] { budget.set_value(loops[0]->spin_budget()); });
+    EXPECT_LT(budget.get_future().get(), 200us);
+
+    // 启动后也可以修改
+    _pool->set_busy_poll(0us);
+    for(EventLoop* loop : loops) {
+        EXPECT_EQ(loop->busy_poll(), 0us);
+    }
+}
+
+
+// TAG: 汇总所有loop的运行指标
+TEST_F(EventLoopThreadPoolTest, Metrics) {
+    _pool->set_thread_num(3);
+    _pool->start();
+
+    std::atomic<int> count { 0 };
+    for(EventLoop* loop : _pool->get_all_loops()) {
+        for(int i = 0; i < 10; ++i) {
+            loop->run_in_loop([&] { ++count; });
+        }
+    }
+
+    int waitCount = 0;
+    while(count.load() < 30 && waitCount++ < 100) {
+        usleep(10000);
+    }
+    ASSERT_EQ(count.load(), 30);
+
+    // 任务执行后指标才会记录, 等待最后一轮循环结束
+    waitCount = 0;
+    while(_pool->metrics().tasks < 30 && waitCount++ < 100) {
+        usleep(10000);
+    }
+
+    EventLoopMetrics::Snapshot m = _pool->metrics();
+    EXPECT_EQ(m.loops, 3);
+    EXPECT_EQ(m.tasks, 30);
+    EXPECT_GE(m.iterations, 3);
+    EXPECT_EQ(m.iteration_ns.count, m.iterations);
+
+    // 停止后从loop已经析构, 只汇总main_loop
+    _pool->stop();
+    EXPECT_EQ(_pool->get_all_loops(), std::vector<EventLoop*>{ _mainLoop.get() });
+    EXPECT_EQ(_pool->metrics().loops, 1);
+}
+
+
+// TAG: 从loop线程在创建EventLoop之前绑定到分配的CPU上
+TEST_F(EventLoopThreadPoolTest, Placement) {
+    _pool->set_thread_num(2);
+    _pool->set_placement(PlacementPolicy::kPerCore);
+    _pool->start();
+
+    auto expected = EventLoopThreadPool::plan_placement(CpuTopology::detect(), PlacementPolicy::kPerCore, 2);
+    ASSERT_EQ(expected.size(), 2);
+
+    auto loops = _pool->get_all_loops();
+    for(std::size_t i = 0; i < loops.size(); ++i) {
+        std::promise<std::vector<int>> affinity;
+        loops[i]->run_in_loop([&] {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            sched_getaffinity(0, sizeof(set), &set);
+
+            std::vector<int> cpus;
+            for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if(CPU_ISSET(cpu, &set)) {
+                    cpus.push_back(cpu);
+                }
+            }
+            affinity.set_value(cpus);
+        });
+
+        std::vector<int> planned = expected[i].cpus;
+        std::sort(planned.begin(), planned.end());
+        EXPECT_EQ(affinity.get_future().get(), planned);
+    }
+}
+
 } // 匿名
 
 int main(int argc, char** argv) {
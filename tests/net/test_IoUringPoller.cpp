@@ -0,0 +1,800 @@
+#include "mymuduo/net/Channel.h"
+#include "mymuduo/net/EventLoop.h"
+#include "mymuduo/net/EventLoopThread.h"
+#include "mymuduo/net/SocketOps.h"
+#include "mymuduo/net/TcpConnection.h"
+#include "mymuduo/net/poller/IoUringPoller.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+class IoUringPollerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        _loop = std::make_unique<EventLoop>();
+        _poller = dynamic_cast<IoUringPoller*>(_loop->poller());
+        if(!_poller) {
+            GTEST_SKIP() << "io_uring is not available, EventLoop fell back to epoll.";
+        }
+
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, _fds), 0);
+    }
+
+    void TearDown() override {
+        if(_poller) {
+            sockets::close(_fds[0]);
+            sockets::close(_fds[1]);
+        }
+    }
+
+protected:
+    std::unique_ptr<EventLoop> _loop;
+    IoUringPoller* _poller = nullptr;
+    int _fds[2] { -1, -1 };
+};
+
+
+// TAG: LT语义: 数据没有读完时每一轮都会触发读事件
+TEST_F(IoUringPollerTest, LevelTriggeredRead) {
+    int reads = 0;
+    Channel ch(_loop.get(), _fds[0]);
+    ch.set_read_callback([&](Timestamp) { ++reads; });
+    ch.set_read_events();
+
+    _loop->loop_once(10ms);
+    EXPECT_EQ(reads, 0);
+
+    ASSERT_EQ(::write(_fds[1], "ping", 4), 4);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 1);
+
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 2);
+
+    char buf[8];
+    ASSERT_EQ(::read(_fds[0], buf, sizeof(buf)), 4);
+    _loop->loop_once(10ms);
+    EXPECT_EQ(reads, 2);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: ET语义: multishot的poll只在新数据到来时触发
+TEST_F(IoUringPollerTest, EdgeTriggeredRead) {
+    int reads = 0;
+    Channel ch(_loop.get(), _fds[0]);
+    ch.set_read_callback([&](Timestamp) { ++reads; });
+    ch.set_ET();
+    ch.set_read_events();
+    _loop->loop_once(10ms);
+
+    ASSERT_EQ(::write(_fds[1], "a", 1), 1);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 1);
+
+    // 没有新数据, 不会再次触发
+    _loop->loop_once(10ms);
+    EXPECT_EQ(reads, 1);
+
+    ASSERT_EQ(::write(_fds[1], "b", 1), 1);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 2);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: 一轮中多次修改监听事件只需要一次io_uring_enter, 已取消的EPOLLOUT不会再回调
+TEST_F(IoUringPollerTest, BatchedUpdates) {
+    int writes = 0;
+    Channel ch(_loop.get(), _fds[0]);
+    ch.set_write_callback([&] { ++writes; });
+    ch.set_read_events();
+
+    for(int i = 0; i < 100; ++i) {
+        ch.set_write_events();
+        ch.unset_write_events();
+    }
+    ch.set_write_events();
+
+    const std::size_t before = _poller->enter_calls();
+    _loop->loop_once(100ms);
+    EXPECT_EQ(_poller->enter_calls() - before, 1);
+    EXPECT_EQ(writes, 1);
+
+    // 取消写事件后, socket仍然可写, 但不会回调
+    ch.unset_write_events();
+    _loop->loop_once(10ms);
+    _loop->loop_once(10ms);
+    EXPECT_EQ(writes, 1);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: 一轮中的请求超过提交队列的大小时, 先提交已填写的请求, 不会覆盖还未被内核取走的SQE
+TEST_F(IoUringPollerTest, SubmissionQueueOverflow) {
+    constexpr int kChannels = IoUringPoller::kEntries * 2 + 10;
+
+    std::vector<int> fds;
+    std::vector<std::unique_ptr<Channel>> channels;
+    int reads = 0;
+    for(int i = 0; i < kChannels; ++i) {
+        int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        ASSERT_GE(fd, 0);
+        fds.push_back(fd);
+
+        channels.emplace_back(std::make_unique<Channel>(_loop.get(), fd));
+        channels.back()->set_read_callback([&reads, fd](Timestamp) {
+            uint64_t value;
+            ASSERT_EQ(::read(fd, &value, sizeof(value)), static_cast<ssize_t>(sizeof(value)));
+            ++reads;
+        });
+        channels.back()->set_read_events();
+    }
+    _loop->loop_once(10ms);
+
+    for(int fd : fds) {
+        uint64_t one = 1;
+        ASSERT_EQ(::write(fd, &one, sizeof(one)), static_cast<ssize_t>(sizeof(one)));
+    }
+    for(int i = 0; i < 10 && reads < kChannels; ++i) {
+        _loop->loop_once(10ms);
+    }
+    EXPECT_EQ(reads, kChannels);
+
+    for(auto& ch : channels) {
+        ch->unset_all_events();
+        ch->remove();
+    }
+    for(int fd : fds) {
+        ::close(fd);
+    }
+}
+
+
+// TAG: 没有事件时按超时返回
+TEST_F(IoUringPollerTest, Timeout) {
+    auto start = Timestamp::now();
+    _loop->loop_once(50ms);
+    int64_t elapsed = time_difference(Timestamp::now(), start);
+    EXPECT_GE(elapsed, 40 * 1000 * 1000);
+    EXPECT_LT(elapsed, 1000 * 1000 * 1000);
+}
+
+
+// TAG: 移除Channel后复用相同的fd, 旧请求的完成事件被忽略
+TEST_F(IoUringPollerTest, RemoveAndReuseFd) {
+    int old_reads = 0;
+    int new_reads = 0;
+    const int fd = _fds[0];
+
+    {
+        Channel ch(_loop.get(), fd);
+        ch.set_read_callback([&](Timestamp) { ++old_reads; });
+        ch.set_read_events();
+        _loop->loop_once(10ms);
+        ch.unset_all_events();
+        ch.remove();
+    }
+
+    Channel ch(_loop.get(), fd);
+    ch.set_read_callback([&](Timestamp) { ++new_reads; });
+    ch.set_read_events();
+
+    ASSERT_EQ(::write(_fds[1], "x", 1), 1);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(old_reads, 0);
+    EXPECT_EQ(new_reads, 1);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: 没有移除就被析构的Channel残留的状态(完成模式, 已收到的数据)不会被复用相同fd的新Channel继承
+TEST_F(IoUringPollerTest, ReuseFdResetsStaleState) {
+    const int fd = _fds[0];
+    {
+        Channel ch(_loop.get(), fd);
+        if(!_poller->set_completion_recv(&ch, true)) {
+            GTEST_SKIP() << "multishot recv with provided buffers is not supported.";
+        }
+        ch.set_read_callback([](Timestamp) { });
+        ch.set_read_events();
+        _loop->loop_once(10ms);
+
+        // 收到的数据不取出, 之后取消事件, 不调用remove
+        ASSERT_EQ(::write(_fds[1], "x", 1), 1);
+        _loop->loop_once(100ms);
+        EXPECT_LT(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+        ch.unset_all_events();
+        _loop->loop_once(10ms);
+    }
+
+    std::string got;
+    Channel ch(_loop.get(), fd);
+    ch.set_read_callback([&](Timestamp) {
+        char buf[16];
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        if(n > 0) {
+            got.append(buf, n);
+        }
+    });
+    ch.set_read_events();
+    EXPECT_EQ(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+
+    // 新的Channel按读就绪事件读取, 不会收到旧Channel的数据
+    ASSERT_EQ(::write(_fds[1], "y", 1), 1);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(got, "y");
+    EXPECT_FALSE(_poller->recv_pending(&ch));
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: 移除Channel后关闭监听socket, 进行中的poll请求不能让socket继续接受连接
+TEST_F(IoUringPollerTest, RemoveReleasesFile) {
+    int listenfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ASSERT_GE(listenfd, 0);
+
+    sockaddr_in addr {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::bind(listenfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    ASSERT_EQ(::listen(listenfd, 16), 0);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(::getsockname(listenfd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+
+    {
+        Channel ch(_loop.get(), listenfd);
+        ch.set_read_events();
+        _loop->loop_once(10ms);
+        ch.unset_all_events();
+        ch.remove();
+    }
+    sockets::close(listenfd);
+
+    int connfd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    ASSERT_GE(connfd, 0);
+    EXPECT_EQ(::connect(connfd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), -1);
+    EXPECT_EQ(errno, ECONNREFUSED);
+    sockets::close(connfd);
+}
+
+
+// TAG: 完成式接收: 数据由内核写入共享缓冲区, 取出后缓冲区归还; 对端关闭后取到0
+TEST_F(IoUringPollerTest, CompletionRecv) {
+    Channel ch(_loop.get(), _fds[0]);
+    if(!_poller->set_completion_recv(&ch, true)) {
+        GTEST_SKIP() << "multishot recv with provided buffers is not supported.";
+    }
+    EXPECT_EQ(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+
+    Buffer buf;
+    ssize_t last = -1;
+    int reads = 0;
+    ch.set_read_callback([&](Timestamp) {
+        ++reads;
+        last = _poller->take_received(&ch, &buf);
+    });
+    ch.set_read_events();
+
+    // 空闲时不占用缓冲区
+    _loop->loop_once(10ms);
+    EXPECT_EQ(reads, 0);
+    EXPECT_EQ(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+
+    ASSERT_EQ(::write(_fds[1], "hello", 5), 5);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 1);
+    EXPECT_EQ(last, 5);
+    EXPECT_EQ(buf.retrieve_all_as_string(), "hello");
+    EXPECT_EQ(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+
+    // 大于一个缓冲区的数据分散在多个缓冲区中
+    const std::string big(IoUringPoller::kRecvBufferSize * 3, 'x');
+    ASSERT_EQ(::write(_fds[1], big.data(), big.size()), static_cast<ssize_t>(big.size()));
+    std::string got;
+    for(int i = 0; i < 10 && got.size() < big.size(); ++i) {
+        _loop->loop_once(100ms);
+        got += buf.retrieve_all_as_string();
+    }
+    EXPECT_EQ(got, big);
+
+    ::shutdown(_fds[1], SHUT_WR);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(last, 0);
+    EXPECT_EQ(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: 取出数据后缓冲区写回缓冲区环, 多次绕过环的末尾后仍然可用
+TEST_F(IoUringPollerTest, CompletionRecvRingWraps) {
+    Channel ch(_loop.get(), _fds[0]);
+    if(!_poller->set_completion_recv(&ch, true)) {
+        GTEST_SKIP() << "multishot recv with provided buffers is not supported.";
+    }
+
+    Buffer buf;
+    ch.set_read_callback([&](Timestamp) { _poller->take_received(&ch, &buf); });
+    ch.set_read_events();
+    _loop->loop_once(10ms);
+
+    std::size_t expected = 0;
+    for(unsigned i = 0; i < IoUringPoller::kRecvBuffers * 3; ++i) {
+        ASSERT_EQ(::write(_fds[1], "0123456789", 10), 10);
+        expected += 10;
+        _loop->loop_once(100ms);
+        ASSERT_EQ(buf.readable(), expected) << "round " << i;
+    }
+    EXPECT_EQ(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: 未取出的数据与LT相同, 每一轮都会通知; 暂停读取时保留数据, 恢复后再通知
+TEST_F(IoUringPollerTest, CompletionRecvLevelTriggered) {
+    Channel ch(_loop.get(), _fds[0]);
+    if(!_poller->set_completion_recv(&ch, true)) {
+        GTEST_SKIP() << "multishot recv with provided buffers is not supported.";
+    }
+
+    int reads = 0;
+    ch.set_read_callback([&](Timestamp) { ++reads; });
+    ch.set_read_events();
+    _loop->loop_once(10ms);
+
+    ASSERT_EQ(::write(_fds[1], "ping", 4), 4);
+    _loop->loop_once(100ms);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 2);
+
+    ch.unset_read_events();
+    ch.set_write_events();
+    _loop->loop_once(10ms);
+    EXPECT_EQ(reads, 2);
+
+    ch.unset_write_events();
+    ch.set_read_events();
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 3);
+
+    Buffer buf;
+    EXPECT_EQ(_poller->take_received(&ch, &buf), 4);
+    EXPECT_EQ(_poller->take_received(&ch, &buf), -1);
+    EXPECT_EQ(errno, EAGAIN);
+
+    ch.unset_all_events();
+    ch.remove();
+    EXPECT_EQ(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+}
+
+
+// TAG: 开启完成式接收的TcpConnection: 消息回调收到数据, 对端关闭后连接关闭
+TEST_F(IoUringPollerTest, CompletionRecvConnection) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+
+    auto conn = std::make_shared<TcpConnection>(_loop.get(), 1, "uring", fds[0], InetAddress(), InetAddress());
+    std::string received;
+    bool closed = false;
+    Buffer* input = nullptr;
+    conn->set_message_callback([&](const TcpConnectionPtr&, Buffer* buf, Timestamp) {
+        input = buf;
+        received += buf->retrieve_all_as_string();
+    });
+    conn->set_close_callback([&](const TcpConnectionPtr&) { closed = true; });
+    conn->set_completion_recv(true);
+    conn->established();
+    if(!conn->completion_recv()) {
+        sockets::close(fds[1]);
+        conn->destroyed();
+        GTEST_SKIP() << "multishot recv with provided buffers is not supported.";
+    }
+
+    ASSERT_EQ(::write(fds[1], "abc", 3), 3);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(received, "abc");
+
+    // 数据被全部取走后输入缓冲区立即归还, 空闲时不占用接收内存
+    ASSERT_NE(input, nullptr);
+    EXPECT_TRUE(input->released());
+    EXPECT_EQ(conn->buffer_bytes(), 0);
+
+    // 回复由发送请求在下一轮提交
+    conn->send(std::string("pong"));
+    char buf[8];
+    EXPECT_EQ(::read(fds[1], buf, sizeof(buf)), conn->completion_send() ? -1 : 4);
+    if(conn->completion_send()) {
+        _loop->loop_once(100ms);
+        ASSERT_EQ(::read(fds[1], buf, sizeof(buf)), 4);
+    }
+
+    sockets::close(fds[1]);
+    for(int i = 0; i < 10 && !closed; ++i) {
+        _loop->loop_once(100ms);
+    }
+    EXPECT_TRUE(closed);
+
+    conn->destroyed();
+    EXPECT_EQ(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+}
+
+
+// TAG: 完成式接收的连接开始转发时, 内核已经收到但还未收割的数据不会丢失, 且排在socket中的数据之前
+TEST_F(IoUringPollerTest, CompletionRecvRelay) {
+    int fds[2];
+    int other[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, other), 0);
+
+    auto a = std::make_shared<TcpConnection>(_loop.get(), 1, "uring", fds[0], InetAddress(), InetAddress());
+    auto b = std::make_shared<TcpConnection>(_loop.get(), 2, "peer", other[0], InetAddress(), InetAddress());
+    bool closed = false;
+    a->set_close_callback([&](const TcpConnectionPtr&) { closed = true; });
+    a->set_completion_recv(true);
+    a->established();
+    b->established();
+    if(!a->completion_recv()) {
+        sockets::close(fds[1]);
+        sockets::close(other[1]);
+        a->destroyed();
+        b->destroyed();
+        GTEST_SKIP() << "multishot recv with provided buffers is not supported.";
+    }
+    _loop->loop_once(10ms);
+
+    // 写入后内核立即由recv请求取走数据, 完成事件还未被收割时开始转发
+    std::string sent;
+    for(int i = 0; i < 8; ++i) {
+        const std::string chunk(1000, static_cast<char>('a' + i));
+        ASSERT_EQ(::write(fds[1], chunk.data(), chunk.size()), static_cast<ssize_t>(chunk.size()));
+        sent += chunk;
+    }
+    a->relay_to(b);
+    EXPECT_FALSE(a->completion_recv());
+
+    // 之后的数据留在socket中, 由splice转发
+    const std::string tail(IoUringPoller::kRecvBufferSize * 2, 'z');
+    ASSERT_EQ(::write(fds[1], tail.data(), tail.size()), static_cast<ssize_t>(tail.size()));
+    sent += tail;
+    ::shutdown(fds[1], SHUT_WR);
+
+    std::string got;
+    char buf[4096];
+    for(int i = 0; i < 50 && got.size() < sent.size(); ++i) {
+        _loop->loop_once(20ms);
+        ssize_t n;
+        while((n = ::read(other[1], buf, sizeof(buf))) > 0) {
+            got.append(buf, n);
+        }
+    }
+    EXPECT_EQ(got.size(), sent.size());
+    EXPECT_TRUE(got == sent);
+
+    for(int i = 0; i < 10 && !closed; ++i) {
+        _loop->loop_once(20ms);
+    }
+    EXPECT_TRUE(closed);
+
+    a->destroyed();
+    b->destroyed();
+    sockets::close(fds[1]);
+    sockets::close(other[1]);
+    EXPECT_EQ(_poller->free_recv_buffers(), IoUringPoller::kRecvBuffers);
+}
+
+
+// TAG: 完成式发送: 请求进行中不监听写就绪事件, 完成时通知写事件, 内存持有到请求完成
+TEST_F(IoUringPollerTest, CompletionSend) {
+    int writes = 0;
+    Channel ch(_loop.get(), _fds[0]);
+    ch.set_write_callback([&] { ++writes; });
+    if(!_poller->set_completion_send(&ch, true)) {
+        GTEST_SKIP() << "io_uring send requests are not supported.";
+    }
+    ch.set_read_events();
+    _loop->loop_once(10ms);
+
+    auto message = std::make_shared<const std::string>("completion send");
+    ch.set_write_events();
+    ASSERT_TRUE(_poller->submit_send(&ch, message->data(), message->size(), false, message));
+    EXPECT_FALSE(_poller->submit_send(&ch, message->data(), message->size(), false, message));
+    EXPECT_EQ(_poller->inflight_sends(), 1u);
+
+    // 结果取出之前不接受新的请求
+    _loop->loop_once(100ms);
+    EXPECT_EQ(writes, 1);
+    EXPECT_EQ(_poller->inflight_sends(), 0u);
+    EXPECT_FALSE(_poller->submit_send(&ch, message->data(), message->size(), false, message));
+    EXPECT_EQ(_poller->take_sent(&ch), static_cast<ssize_t>(message->size()));
+    EXPECT_EQ(_poller->take_sent(&ch), -1);
+    EXPECT_EQ(errno, EAGAIN);
+
+    char buf[64];
+    ASSERT_EQ(::read(_fds[1], buf, sizeof(buf)), static_cast<ssize_t>(message->size()));
+    EXPECT_EQ(std::string(buf, message->size()), *message);
+
+    // 没有发送请求时照常按写就绪事件通知
+    _loop->loop_once(100ms);
+    EXPECT_EQ(writes, 2);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: 完成式连接的发送经过输出缓冲区, 一个请求覆盖多个块, 数据按顺序到达, 全部完成后触发写完回调
+TEST_F(IoUringPollerTest, CompletionSendConnection) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+
+    auto conn = std::make_shared<TcpConnection>(_loop.get(), 1, "uring", fds[0], InetAddress(), InetAddress());
+    int write_completes = 0;
+    conn->set_write_complete_callback([&](const TcpConnectionPtr&) { ++write_completes; });
+    conn->set_completion_recv(true);
+    conn->established();
+    if(!conn->completion_send()) {
+        sockets::close(fds[1]);
+        conn->destroyed();
+        GTEST_SKIP() << "io_uring send requests are not supported.";
+    }
+    _loop->loop_once(10ms);
+
+    // 超过socket缓冲区的数据, 分多次请求发送
+    std::string sent;
+    for(int i = 0; i < 64; ++i) {
+        std::string chunk(10000 + i * 97, static_cast<char>('a' + i % 26));
+        sent += chunk;
+        conn->send(std::move(chunk));
+    }
+    EXPECT_EQ(_poller->send_requests(), 1u);
+
+    std::string got;
+    char buf[65536];
+    for(int i = 0; i < 200 && (got.size() < sent.size() || write_completes == 0); ++i) {
+        _loop->loop_once(10ms);
+        ssize_t n;
+        while((n = ::read(fds[1], buf, sizeof(buf))) > 0) {
+            got.append(buf, n);
+        }
+    }
+    EXPECT_EQ(got.size(), sent.size());
+    EXPECT_TRUE(got == sent);
+    EXPECT_EQ(write_completes, 1);
+    EXPECT_LT(_poller->send_requests(), sent.size() / ChainBuffer::kBlockSize);
+    EXPECT_EQ(_poller->zero_copy_requests(), 0u);
+    EXPECT_EQ(_poller->inflight_sends(), 0u);
+
+    conn->destroyed();
+    sockets::close(fds[1]);
+}
+
+
+// TAG: 完成式连接的大批量发送, 每个请求平均发送多个块, 吞吐量不受单个块大小的限制
+TEST_F(IoUringPollerTest, CompletionSendBulk) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+
+    auto conn = std::make_shared<TcpConnection>(_loop.get(), 1, "uring", fds[0], InetAddress(), InetAddress());
+    int write_completes = 0;
+    conn->set_write_complete_callback([&](const TcpConnectionPtr&) { ++write_completes; });
+    conn->set_completion_recv(true);
+    conn->established();
+    if(!conn->completion_send()) {
+        sockets::close(fds[1]);
+        conn->destroyed();
+        GTEST_SKIP() << "io_uring send requests are not supported.";
+    }
+    _loop->loop_once(10ms);
+
+    const size_t total = 32 * 1024 * 1024;
+    const size_t chunk_size = 256 * 1024;
+    size_t queued = 0;
+    uint64_t expected_sum = 0;
+    uint64_t got_sum = 0;
+    size_t got = 0;
+    std::string chunk(chunk_size, 0);
+    char buf[256 * 1024];
+
+    Timestamp start = Timestamp::now();
+    for(int i = 0; i < 100000 && (got < total || write_completes == 0); ++i) {
+        // 对端还未收到的数据保持积压, 每次补充一个报文
+        if(queued < total && queued - got < 4 * chunk_size) {
+            for(size_t j = 0; j < chunk_size; ++j) {
+                chunk[j] = static_cast<char>((queued + j) * 131 >> 7);
+                expected_sum += static_cast<unsigned char>(chunk[j]) * ((queued + j) % 251 + 1);
+            }
+            conn->send(chunk);
+            queued += chunk_size;
+        }
+
+        _loop->loop_once(1ms);
+        ssize_t n;
+        while((n = ::read(fds[1], buf, sizeof(buf))) > 0) {
+            for(ssize_t j = 0; j < n; ++j) {
+                got_sum += static_cast<unsigned char>(buf[j]) * ((got + j) % 251 + 1);
+            }
+            got += n;
+        }
+    }
+    const double seconds = std::max(1e-9, time_difference(Timestamp::now(), start) / 1e9);
+
+    EXPECT_EQ(got, total);
+    EXPECT_EQ(got_sum, expected_sum);
+    EXPECT_EQ(write_completes, 1);
+    EXPECT_EQ(_poller->inflight_sends(), 0u);
+
+    // 逐块发送时请求数不少于块数
+    const size_t blocks = total / ChainBuffer::kBlockSize;
+    EXPECT_LT(_poller->send_requests() * 2, blocks);
+    ::testing::Test::RecordProperty("send_requests", static_cast<int>(_poller->send_requests()));
+    ::testing::Test::RecordProperty("MiB_per_second", static_cast<int>(total / seconds / (1024 * 1024)));
+
+    conn->destroyed();
+    sockets::close(fds[1]);
+}
+
+
+// TAG: 完成式发送与sendfile交错时保持先后顺序
+TEST_F(IoUringPollerTest, CompletionSendFile) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+
+    auto conn = std::make_shared<TcpConnection>(_loop.get(), 1, "uring", fds[0], InetAddress(), InetAddress());
+    conn->set_completion_recv(true);
+    conn->established();
+    if(!conn->completion_send()) {
+        sockets::close(fds[1]);
+        conn->destroyed();
+        GTEST_SKIP() << "io_uring send requests are not supported.";
+    }
+
+    std::string content(256 * 1024, 'f');
+    for(size_t i = 0; i < content.size(); i += 1000) {
+        content[i] = static_cast<char>('a' + i / 1000 % 26);
+    }
+    char path[] = "/tmp/test_IoUringPoller_XXXXXX";
+    int file_fd = ::mkstemp(path);
+    ASSERT_GE(file_fd, 0);
+    ::unlink(path);
+    ASSERT_EQ(::write(file_fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+
+    // 文件加入时前面的数据还在发送请求中
+    const std::string head(40000, 'h');
+    conn->send(std::string(head));
+    conn->send_file(file_fd, 0, content.size());
+    ::close(file_fd);
+    conn->send(std::string("tail"));
+
+    const std::string expected = head + content + "tail";
+    std::string got;
+    char buf[65536];
+    for(int i = 0; i < 200 && got.size() < expected.size(); ++i) {
+        _loop->loop_once(10ms);
+        ssize_t n;
+        while((n = ::read(fds[1], buf, sizeof(buf))) > 0) {
+            got.append(buf, n);
+        }
+    }
+    EXPECT_EQ(got.size(), expected.size());
+    EXPECT_TRUE(got == expected);
+
+    conn->destroyed();
+    sockets::close(fds[1]);
+}
+
+
+// TAG: 零拷贝的发送请求, 输出缓冲区的块持有到内核的完成通知
+TEST_F(IoUringPollerTest, CompletionSendZeroCopy) {
+    // socketpair不支持零拷贝, 使用回环地址上的tcp连接
+    int listenfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listenfd, 0);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_t addrlen = sizeof addr;
+    ASSERT_EQ(::bind(listenfd, reinterpret_cast<sockaddr*>(&addr), sizeof addr), 0);
+    ASSERT_EQ(::listen(listenfd, 1), 0);
+    ASSERT_EQ(::getsockname(listenfd, reinterpret_cast<sockaddr*>(&addr), &addrlen), 0);
+
+    int clientfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(::connect(clientfd, reinterpret_cast<sockaddr*>(&addr), sizeof addr), 0);
+    int serverfd = ::accept4(listenfd, nullptr, nullptr, SOCK_NONBLOCK);
+    ASSERT_GE(serverfd, 0);
+
+    auto conn = std::make_shared<TcpConnection>(_loop.get(), 1, "uring", serverfd, InetAddress(), InetAddress());
+    conn->set_completion_recv(true);
+    conn->established();
+    if(!conn->completion_send() || !conn->set_zero_copy(4096)) {
+        conn->destroyed();
+        ::close(clientfd);
+        ::close(listenfd);
+        GTEST_SKIP() << "io_uring zero copy send is not supported.";
+    }
+
+    std::string sent;
+    for(int i = 0; i < 16; ++i) {
+        std::string chunk(20000, static_cast<char>('A' + i));
+        sent += chunk;
+        conn->send(chunk);
+    }
+
+    std::string got;
+    char buf[65536];
+    for(int i = 0; i < 200 && (got.size() < sent.size() || _poller->inflight_sends() > 0); ++i) {
+        _loop->loop_once(10ms);
+        ssize_t n;
+        while((n = ::recv(clientfd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+            got.append(buf, n);
+        }
+    }
+    EXPECT_TRUE(got == sent);
+    EXPECT_GT(_poller->zero_copy_requests(), 0u);
+    EXPECT_EQ(_poller->inflight_sends(), 0u);
+    EXPECT_TRUE(conn->connected());
+
+    conn->destroyed();
+    ::close(clientfd);
+    ::close(listenfd);
+}
+
+
+// TAG: 其它线程投递的任务通过eventfd唤醒io_uring上的loop
+TEST(IoUringLoopThreadTest, CrossThreadWakeup) {
+    EventLoopThread thread;
+    EventLoop* loop = thread.start_loop();
+    ASSERT_NE(loop, nullptr);
+
+    std::atomic<int> count { 0 };
+    for(int i = 0; i < 100; ++i) {
+        loop->queue_in_loop([&] { ++count; });
+        usleep(100);
+    }
+
+    int waitCount = 0;
+    while(count.load() < 100 && waitCount++ < 100) {
+        usleep(10000);
+    }
+    EXPECT_EQ(count.load(), 100);
+}
+
+}
+
+int main(int argc, char** argv) {
+    // 本测试中所有的EventLoop都使用io_uring
+    ::setenv("MUDUO_USE_URING", "1", 1);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,192 @@
+#include "mymuduo/net/Channel.h"
+#include "mymuduo/net/EventLoop.h"
+#include "mymuduo/net/EventLoopThread.h"
+#include "mymuduo/net/SocketOps.h"
+#include "mymuduo/net/poller/PollPoller.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+using namespace mymuduo;
+using namespace mymuduo::net;
+
+class PollPollerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        _loop = std::make_unique<EventLoop>();
+        ASSERT_NE(dynamic_cast<PollPoller*>(_loop->poller()), nullptr);
+    }
+
+    // 创建一对socket, 返回读端
+    int make_pair() {
+        int fds[2];
+        EXPECT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds), 0);
+        _fds.push_back(fds[0]);
+        _fds.push_back(fds[1]);
+        return fds[0];
+    }
+
+    // 读端对应的写端
+    int peer(int fd) {
+        for(std::size_t i = 0; i < _fds.size(); i += 2) {
+            if(_fds[i] == fd) {
+                return _fds[i + 1];
+            }
+        }
+        return -1;
+    }
+
+    void TearDown() override {
+        for(int fd : _fds) {
+            sockets::close(fd);
+        }
+    }
+
+protected:
+    std::unique_ptr<EventLoop> _loop;
+    std::vector<int> _fds;
+};
+
+
+// TAG: LT语义: 数据没有读完时每一轮都会触发读事件
+TEST_F(PollPollerTest, LevelTriggeredRead) {
+    const int fd = make_pair();
+    int reads = 0;
+    Channel ch(_loop.get(), fd);
+    ch.set_read_callback([&](Timestamp) { ++reads; });
+    ch.set_read_events();
+
+    _loop->loop_once(10ms);
+    EXPECT_EQ(reads, 0);
+
+    ASSERT_EQ(::write(peer(fd), "ping", 4), 4);
+    _loop->loop_once(100ms);
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 2);
+
+    char buf[8];
+    ASSERT_EQ(::read(fd, buf, sizeof(buf)), 4);
+    _loop->loop_once(10ms);
+    EXPECT_EQ(reads, 2);
+
+    ch.unset_all_events();
+    ch.remove();
+}
+
+
+// TAG: 取消所有事件的Channel保留在数组中但不再触发, 重新监听后恢复
+TEST_F(PollPollerTest, DisableAndEnable) {
+    const int fd = make_pair();
+    int reads = 0;
+    int writes = 0;
+    Channel ch(_loop.get(), fd);
+    ch.set_read_callback([&](Timestamp) { ++reads; });
+    ch.set_write_callback([&] { ++writes; });
+
+    ch.set_write_events();
+    _loop->loop_once(100ms);
+    EXPECT_EQ(writes, 1);
+    const int index = ch.index();
+    EXPECT_GE(index, 0);
+
+    ch.unset_all_events();
+    ASSERT_EQ(::write(peer(fd), "x", 1), 1);
+    _loop->loop_once(10ms);
+    EXPECT_EQ(reads, 0);
+    EXPECT_EQ(writes, 1);
+    EXPECT_EQ(ch.index(), index);
+
+    ch.set_read_events();
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, 1);
+    EXPECT_EQ(writes, 1);
+
+    ch.unset_all_events();
+    ch.remove();
+    EXPECT_EQ(ch.index(), -1);
+}
+
+
+// TAG: 删除中间的Channel时与末尾交换, 被移动的Channel仍然正常工作
+TEST_F(PollPollerTest, SwapRemove) {
+    constexpr int kChannels = 4;
+    std::vector<std::unique_ptr<Channel>> channels;
+    std::vector<int> reads(kChannels, 0);
+
+    // EventLoop自身的Channel(唤醒, 定时器)排在前面
+    int base = -1;
+    for(int i = 0; i < kChannels; ++i) {
+        const int fd = make_pair();
+        channels.emplace_back(std::make_unique<Channel>(_loop.get(), fd));
+        channels[i]->set_read_callback([&reads, i](Timestamp) { ++reads[i]; });
+        channels[i]->set_read_events();
+        if(i == 0) {
+            base = channels[0]->index();
+        }
+        EXPECT_EQ(channels[i]->index(), base + i);
+    }
+
+    channels[1]->unset_all_events();
+    channels[1]->remove();
+    EXPECT_EQ(channels[1]->index(), -1);
+    EXPECT_EQ(channels[3]->index(), base + 1);
+
+    for(int i = 0; i < kChannels; ++i) {
+        ASSERT_EQ(::write(peer(channels[i]->fd()), "x", 1), 1);
+    }
+    _loop->loop_once(100ms);
+    EXPECT_EQ(reads, (std::vector<int> { 1, 0, 1, 1 }));
+
+    for(int i : { 0, 2, 3 }) {
+        channels[i]->unset_all_events();
+        channels[i]->remove();
+    }
+}
+
+
+// TAG: 没有事件时按超时返回
+TEST_F(PollPollerTest, Timeout) {
+    auto start = Timestamp::now();
+    _loop->loop_once(50ms);
+    int64_t elapsed = time_difference(Timestamp::now(), start);
+    EXPECT_GE(elapsed, 40 * 1000 * 1000);
+    EXPECT_LT(elapsed, 1000 * 1000 * 1000);
+}
+
+
+// TAG: 其它线程投递的任务通过eventfd唤醒poll上的loop
+TEST(PollLoopThreadTest, CrossThreadWakeup) {
+    EventLoopThread thread;
+    EventLoop* loop = thread.start_loop();
+    ASSERT_NE(loop, nullptr);
+
+    std::atomic<int> count { 0 };
+    for(int i = 0; i < 100; ++i) {
+        loop->queue_in_loop([&] { ++count; });
+        usleep(100);
+    }
+
+    int waitCount = 0;
+    while(count.load() < 100 && waitCount++ < 100) {
+        usleep(10000);
+    }
+    EXPECT_EQ(count.load(), 100);
+}
+
+}
+
+int main(int argc, char** argv) {
+    // 本测试中所有的EventLoop都使用poll
+    ::setenv("MUDUO_USE_POLL", "1", 1);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -107,6 +107,7 @@ protected:
             _acceptor.reset();
             for (auto& conn : _serv_connections) {
                 conn->shutdown();
+                conn->destroyed();
             }
             _serv_connections.clear();
         });
@@ -131,8 +132,10 @@ protected:
             conn->send(_serv_received_data); // 回显数据
         });
         
+        // 与TcpServer相同, 在下一轮中从事件循环移除连接
         conn->set_close_callback([this](const TcpConnectionPtr& conn) {
             _serv_connections.erase(conn);
+            _serv_loop->queue_in_loop(std::bind(&TcpConnection::destroyed, conn));
         });
         
         _serv_connections.insert(conn);
@@ -299,12 +302,22 @@ TEST_F(TcpClientTest, DestructsWithConnection) {
     TcpConnectionPtr conn = _client->connection();
     _client.reset();
 
+    // client析构时在loop中替换连接的关闭回调, 等它执行后再关闭服务器
+    std::promise<void> swapped;
+    _clnt_loop->queue_in_loop([&] { swapped.set_value(); });
+    swapped.get_future().wait();
+
     // client被析构后连接仍然有效
     ASSERT_TRUE(wait_for([&] {
         return conn->connected();
     }));
     
     stop_server();
+
+    // 等待连接在client的loop中关闭, 之后由loop移除Channel并释放连接
+    ASSERT_TRUE(wait_for([&] {
+        return !conn->connected();
+    }));
 }
 
 
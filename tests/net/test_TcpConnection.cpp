@@ -17,9 +17,11 @@
 #include <gtest/gtest-death-test.h>
 #include <memory>
 #include <string>
+#include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/syscall.h>
 #include <sys/types.h>
+#include <thread>
 #include <unistd.h>
 
 #include <gtest/gtest.h>
@@ -250,6 +252,240 @@ TEST_F(TcpConnectionTest, LT_DataSend) {
 }
 
 
+// TAG: 发送补上报文头的缓冲区
+TEST_F(TcpConnectionTest, SendBuffer) {
+    auto conn = createConn(false);
+    set_all(conn);
+    conn->established();
+
+    Buffer buf;
+    buf.append("framed");
+    buf.prepend_int32(6);
+
+    conn->send(&buf);
+    EXPECT_EQ(buf.readable(), 0);
+
+    std::string res = readFromServer(10);
+    ASSERT_EQ(res, std::string("\0\0\0\x06" "framed", 10));
+
+    conn->destroyed();
+}
+
+
+// TAG: sendfile发送文件, 与send的数据保持顺序
+TEST_F(TcpConnectionTest, SendFile) {
+    auto conn = createConn(false);
+    set_all(conn);
+    conn->established();
+
+    // 文件大于socket缓冲区, 需要多次写事件才能发送完
+    std::string content(512 * 1024, 'f');
+    for(size_t i = 0; i < content.size(); i += 4096) {
+        content[i] = static_cast<char>('a' + i / 4096 % 26);
+    }
+
+    char path[] = "/tmp/test_TcpConnection_XXXXXX";
+    int file_fd = ::mkstemp(path);
+    ASSERT_GE(file_fd, 0);
+    ::unlink(path);
+    ASSERT_EQ(::write(file_fd, content.data(), content.size()), content.size());
+
+    conn->send(std::string("head"));
+    conn->send_file(file_fd, 16, content.size() - 16);
+    ::close(file_fd);       // 连接持有自己的fd
+    conn->send(std::string("tail"));
+
+    std::string expected = "head" + content.substr(16) + "tail";
+    std::string received;
+    char buf[65536];
+    for(int i = 0; i < 1000 && received.size() < expected.size(); ++i) {
+        _loop->loop_once(10ms);
+        ssize_t n;
+        while((n = ::read(_socketfd[1], buf, sizeof buf)) > 0) {
+            received.append(buf, n);
+        }
+    }
+
+    ASSERT_EQ(received.size(), expected.size());
+    EXPECT_TRUE(received == expected);
+
+    // "head" 直接写完时触发一次, 文件和 "tail" 全部发送后再触发一次
+    _loop->loop_once(10ms);
+    EXPECT_EQ(2, _write_complete_callback_count);
+
+    conn->destroyed();
+}
+
+
+// TAG: 在其它线程中移交报文的所有权
+TEST_F(TcpConnectionTest, SendFromOtherThread) {
+    auto conn = createConn(false);
+    set_all(conn);
+    conn->established();
+
+    std::thread worker([&conn] {
+        // 报文在工作线程中构造, 离开作用域后即被销毁
+        {
+            std::string msg = "string|";
+            conn->send(std::move(msg));
+        }
+        {
+            std::string msg = "copied|";
+            conn->send(msg);
+        }
+        {
+            Buffer buf;
+            buf.append("buffer|");
+            conn->send(std::move(buf));
+        }
+        conn->send(std::make_shared<const std::string>("shared"));
+    });
+    worker.join();
+
+    _loop->loop_once(10ms);
+
+    std::string expected = "string|copied|buffer|shared";
+    ASSERT_EQ(readFromServer(expected.size()), expected);
+
+    conn->destroyed();
+}
+
+
+// TAG: 零拷贝发送, 报文持有到内核的完成通知到达
+TEST_F(TcpConnectionTest, ZeroCopySend) {
+    // socketpair不支持 SO_ZEROCOPY, 使用回环地址上的tcp连接
+    int listenfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listenfd, 0);
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+    socklen_t addrlen = sizeof addr;
+    ASSERT_EQ(::bind(listenfd, reinterpret_cast<sockaddr*>(&addr), sizeof addr), 0);
+    ASSERT_EQ(::listen(listenfd, 1), 0);
+    ASSERT_EQ(::getsockname(listenfd, reinterpret_cast<sockaddr*>(&addr), &addrlen), 0);
+
+    int clientfd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(::connect(clientfd, reinterpret_cast<sockaddr*>(&addr), sizeof addr), 0);
+    int serverfd = ::accept4(listenfd, nullptr, nullptr, SOCK_NONBLOCK);
+    ASSERT_GE(serverfd, 0);
+
+    auto conn = std::make_shared<TcpConnection>(_loop.get(), 2, "ZeroCopySend", serverfd,
+                                                InetAddress{}, InetAddress{});
+    set_all(conn);
+    conn->established();
+
+    if(!conn->set_zero_copy(1024)) {
+        conn->destroyed();
+        ::close(clientfd);
+        ::close(listenfd);
+        GTEST_SKIP() << "SO_ZEROCOPY is not supported";
+    }
+
+    // 小于阈值的报文照常拷贝发送
+    conn->send(std::string("small"));
+    EXPECT_EQ(conn->zero_copy_pending(), 0);
+
+    std::string payload(64 * 1024, 'z');
+    conn->send(std::string(payload));
+    EXPECT_EQ(conn->zero_copy_pending(), 1);
+
+    std::string expected = "small" + payload;
+    std::string received;
+    char buf[65536];
+    for(int i = 0; i < 100 && (received.size() < expected.size() || conn->zero_copy_pending() > 0); ++i) {
+        _loop->loop_once(10ms);
+        ssize_t n;
+        while((n = ::recv(clientfd, buf, sizeof buf, MSG_DONTWAIT)) > 0) {
+            received.append(buf, n);
+        }
+    }
+
+    EXPECT_TRUE(received == expected);
+
+    // 完成通知被取走后报文才释放, 连接不受 EPOLLERR 影响
+    EXPECT_EQ(conn->zero_copy_pending(), 0);
+    EXPECT_TRUE(conn->connected());
+    EXPECT_EQ(0, _close_callback_count);
+
+    conn->destroyed();
+    ::close(clientfd);
+    ::close(listenfd);
+}
+
+
+// TAG: 两个连接之间通过管道双向转发
+TEST_F(TcpConnectionTest, Relay) {
+    int other[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, other), 0);
+
+    auto a = createConn(false);
+    auto b = std::make_shared<TcpConnection>(_loop.get(), 2, "RelayPeer", other[0],
+                                             InetAddress{}, InetAddress{});
+    a->established();
+    b->established();
+    TcpConnection::relay(a, b);
+
+    auto drain = [](int fd, std::string& out) {
+        char buf[65536];
+        ssize_t n;
+        while((n = ::read(fd, buf, sizeof buf)) > 0) {
+            out.append(buf, n);
+        }
+        return n;
+    };
+
+    // 双向转发
+    writeToServer("ping");
+    _loop->loop_once(10ms);
+    std::string res;
+    drain(other[1], res);
+    EXPECT_EQ(res, "ping");
+
+    ASSERT_EQ(::write(other[1], "pong", 4), 4);
+    _loop->loop_once(10ms);
+    EXPECT_EQ(readFromServer(4), "pong");
+
+    // b的对端不读取时, 数据积压在管道和socket缓冲区中, a暂停读取
+    std::string sent;
+    std::string chunk(4096, 0);
+    for(int i = 0; i < 64; ++i) {
+        for(int j = 0; j < 16; ++j) {
+            std::fill(chunk.begin(), chunk.end(), static_cast<char>('a' + sent.size() / 4096 % 26));
+            if(::write(_socketfd[1], chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size())) {
+                break;
+            }
+            sent += chunk;
+        }
+        _loop->loop_once(1ms);
+    }
+    ASSERT_GT(sent.size(), TcpConnection::kRelayPipeSize);
+
+    // 开始读取后, 数据按顺序全部到达
+    res.clear();
+    for(int i = 0; i < 1000 && res.size() < sent.size(); ++i) {
+        drain(other[1], res);
+        _loop->loop_once(1ms);
+    }
+    ASSERT_EQ(res.size(), sent.size());
+    EXPECT_TRUE(res == sent);
+
+    // a的对端关闭后, b的写端随之关闭
+    ::close(_socketfd[1]);
+    closed = true;
+    _loop->loop_once(10ms);
+    _loop->loop_once(10ms);
+
+    res.clear();
+    EXPECT_EQ(drain(other[1], res), 0);
+    EXPECT_TRUE(res.empty());
+
+    a->destroyed();
+    b->destroyed();
+    ::close(other[1]);
+}
+
+
 // TAG: ET模式下数据接收测试
 TEST_F(TcpConnectionTest, ET_DataReceiveFull) {
     auto conn = createConn(true);
@@ -471,6 +707,155 @@ TEST_F(TcpConnectionTest, HandlerWriteError) {
     ASSERT_EQ(0, _high_water_mark_callback_count);
 }
 
+
+// TAG: 大报文过后输入缓冲区自适应收缩
+TEST_F(TcpConnectionTest, ShrinkInputBuffer) {
+    auto conn = createConn(false);
+    set_all(conn);
+
+    auto gauge = std::make_shared<std::atomic<size_t>>(0);
+    conn->set_buffer_gauge(gauge);
+    conn->set_buffer_shrink_policy(2, 0s);
+
+    // 第一次读取后只保留1个字节, 之后不再取走数据
+    size_t max_capacity = 0;
+    conn->set_message_callback([&](const TcpConnectionPtr& conn, Buffer* buf, Timestamp t) {
+        max_capacity = std::max(max_capacity, buf->capacity());
+        if(_message_callback_count++ == 0) {
+            buf->retrieve(buf->readable() - 1);
+        }
+    });
+
+    conn->established();
+
+    writeToServer(std::string(60 * 1024, 'L'));
+    _loop->loop_once();
+    ASSERT_EQ(1, _message_callback_count);
+    ASSERT_GT(max_capacity, 32 * 1024);
+
+    // 第一次未充分使用, 还不会收缩
+    EXPECT_GE(conn->buffer_bytes(), max_capacity);
+    EXPECT_EQ(gauge->load(), conn->buffer_bytes());
+    EXPECT_FALSE(conn->buffers_at_floor());
+
+    writeToServer("small");
+    _loop->loop_once();
+    ASSERT_EQ(2, _message_callback_count);
+
+    // 连续两次未充分使用, 收缩回初始大小附近(payload加初始大小所在的块)
+    EXPECT_LE(conn->buffer_bytes(), 2048);
+    EXPECT_EQ(gauge->load(), conn->buffer_bytes());
+    EXPECT_TRUE(conn->buffers_at_floor());
+
+    conn->destroyed();
+    _conn.reset();
+    conn.reset();
+    EXPECT_EQ(gauge->load(), 0);
+}
+
+// TAG: 内存计数与从内存池借出的内存一致
+TEST_F(TcpConnectionTest, BufferGaugeMatchesPool) {
+    auto conn = createConn(false);
+    set_all(conn);
+
+    auto gauge = std::make_shared<std::atomic<size_t>>(0);
+    conn->set_buffer_gauge(gauge);
+    conn->set_buffer_shrink_policy(0, 0s);
+
+    // 不取走数据, 输入缓冲区保持扩容后的大小
+    conn->established();
+    writeToServer(std::string(66000, 'G'));
+    _loop->loop_once();
+    ASSERT_GE(_message_callback_count, 1);
+
+    const size_t held = conn->buffer_bytes();
+    EXPECT_GT(held, 0);
+    EXPECT_EQ(gauge->load(), held);
+
+    // 析构时借出的块全部归还内存池, 归还的字节数就是实际占用的内存
+    auto pool = _loop->buffer_pool();
+    const size_t cached = pool->cached_bytes();
+    conn->destroyed();
+    _conn.reset();
+    conn.reset();
+    EXPECT_EQ(pool->cached_bytes() - cached, held);
+    EXPECT_EQ(gauge->load(), 0);
+}
+
+// TAG: 输入缓冲区在读取之间保留, 空闲超时后才归还内存池
+TEST_F(TcpConnectionTest, KeepInputBufferUntilIdle) {
+    auto conn = createConn(false);
+    set_all(conn);
+
+    auto gauge = std::make_shared<std::atomic<size_t>>(0);
+    conn->set_buffer_gauge(gauge);
+    conn->set_buffer_shrink_policy(0, 1ms);
+
+    conn->set_message_callback([&](const TcpConnectionPtr& conn, Buffer* buf, Timestamp t) {
+        buf->retrieve_all();
+        ++_message_callback_count;
+    });
+
+    conn->established();
+
+    // 数据被全部取走后, 输入缓冲区仍然保留
+    writeToServer("keep");
+    _loop->loop_once();
+    ASSERT_EQ(1, _message_callback_count);
+    EXPECT_GT(conn->buffer_bytes(), 0);
+    EXPECT_EQ(gauge->load(), conn->buffer_bytes());
+    EXPECT_FALSE(conn->buffers_at_floor());
+
+    // 空闲超过 idle_time 后, 空的输入缓冲区整块归还
+    std::this_thread::sleep_for(2ms);
+    conn->shrink_buffers_if_idle(Timestamp::now());
+    EXPECT_EQ(conn->buffer_bytes(), 0);
+    EXPECT_EQ(gauge->load(), 0);
+    EXPECT_TRUE(conn->buffers_at_floor());
+
+    conn->destroyed();
+}
+
+// TAG: 大报文发送完后输出缓冲区回到初始大小
+TEST_F(TcpConnectionTest, ShrinkOutputBuffer) {
+    auto conn = createConn(false);
+    set_all(conn);
+
+    auto gauge = std::make_shared<std::atomic<size_t>>(0);
+    conn->set_buffer_gauge(gauge);
+
+    conn->established();
+    _loop->loop_once();
+    const size_t baseline = conn->buffer_bytes();
+
+    // 对端不读取, 大部分数据会积压在输出缓冲区中
+    const size_t total = 4 * 1024 * 1024;
+    conn->send(std::string(total, 'S'));
+    ASSERT_GT(conn->buffer_bytes(), baseline + ChainBuffer::kBlockSize);
+    EXPECT_EQ(gauge->load(), conn->buffer_bytes());
+
+    // 对端读空后, 输出缓冲区的块全部释放
+    size_t received = 0;
+    char buf[64 * 1024];
+    for(int i = 0; i < 10000 && (received < total || _write_complete_callback_count == 0); ++i) {
+        ssize_t n = 0;
+        while((n = ::read(_socketfd[1], buf, sizeof(buf))) > 0) {
+            received += n;
+        }
+        _loop->loop_once(1ms);
+    }
+    ASSERT_EQ(received, total);
+    ASSERT_EQ(1, _write_complete_callback_count);
+
+    EXPECT_EQ(conn->buffer_bytes(), baseline);
+    EXPECT_EQ(gauge->load(), baseline);
+
+    conn->destroyed();
+    _conn.reset();
+    conn.reset();
+    EXPECT_EQ(gauge->load(), 0);
+}
+
 } // namespace
 
 int main(int argc, char** argv) {
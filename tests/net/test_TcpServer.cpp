@@ -33,6 +33,8 @@ protected:
                 ));
 
             server->set_connection_callback([this](const TcpConnectionPtr& conn) {
+                std::lock_guard<std::mutex> lock { _mtx };
+
                 // 连接建立
                 if (!_connection_callback_called) {
                     _connection_callback_called = true;
@@ -48,6 +50,7 @@ protected:
             });
 
             server->set_message_callback([this](const TcpConnectionPtr& conn, Buffer* buf, Timestamp t) {
+                std::lock_guard<std::mutex> lock { _mtx };
                 _message_callback_called = true;
                 _message_received = buf->retrieve_all_as_string();
                 _cv.notify_one();
@@ -57,14 +60,18 @@ protected:
             _server = server;
 
             server->start();
-            
+
+            {
+                std::lock_guard<std::mutex> lock { _mtx };
+                _started = true;
+            }
             _cv.notify_one();
             loop->loop();
         });
 
         {
             std::unique_lock<std::mutex> lock { _mtx };
-            _cv.wait(lock);
+            _cv.wait(lock, [this] { return _started; });
         }
     }
 
@@ -92,6 +99,7 @@ protected:
 
     std::mutex _mtx;
     std::condition_variable _cv;
+    bool _started = false;
 
     std::shared_ptr<TcpConnection> _conn;
 
@@ -117,7 +125,7 @@ TEST_F(TcpServerTest, AcceptConnectionAndMessage) {
     // 等待连接建立
     {
         std::unique_lock<std::mutex> lock { _mtx };
-        _cv.wait(lock);
+        _cv.wait(lock, [this] { return _connection_callback_called.load(); });
     }
 
     ASSERT_TRUE(_connection_callback_called);
@@ -131,7 +139,7 @@ TEST_F(TcpServerTest, AcceptConnectionAndMessage) {
     // 等待消息回调
     {
         std::unique_lock<std::mutex> lock { _mtx };
-        _cv.wait(lock);
+        _cv.wait(lock, [this] { return _message_callback_called.load(); });
     }
     ASSERT_TRUE(_message_callback_called);
     ASSERT_EQ(_message_received, msg);
@@ -142,7 +150,7 @@ TEST_F(TcpServerTest, AcceptConnectionAndMessage) {
     // 等待关闭连接回调
     {
         std::unique_lock<std::mutex> lock { _mtx };
-        _cv.wait(lock);
+        _cv.wait(lock, [this] { return _disconnection_callback_called.load(); });
     }
     ASSERT_TRUE(_disconnection_callback_called);
 }